@@ -1,12 +1,45 @@
 #pragma once
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "Interner.h"
+#include "LineIndex.h"
 
+struct ASTNode;
+
+// A node's subtrees: an array in the same arena as the node. Most nodes
+// have at most three; a stmt-list has one per statement in its sequence.
+class ChildList {
+public:
+    ChildList() = default;
+    ChildList(ASTNode** items, size_t count) : items(items), count(count) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    ASTNode* operator[](size_t i) const { return items[i]; }
+    ASTNode* const* begin() const { return items; }
+    ASTNode* const* end() const { return items + count; }
+
+private:
+    ASTNode** items = nullptr;
+    size_t count = 0;
+};
+
+// Nodes live in a SyntaxTree's arena (see SyntaxTree.h), which releases
+// them all at once without running destructors. `type` names a string
+// literal and `value` text in the same arena.
 struct ASTNode {
-    std::string type;                  // "AssignStmt", "Identifier", "Exp",....
-    std::string value;                 // value of token if leaf node
-    std::vector<ASTNode*> children;    // subtrees
+    std::string_view type;             // "if", "stmt-list", "op", "assign", "id",....
+    std::string_view value;            // value of token if leaf node, e.g. "(x)"
+    ChildList children;                // subtrees
+    SourceSpan span;                   // source text of this node
+    SymbolId symbol = NoSymbol;        // the identifier of "id", "assign" and "read" nodes, as in FlatAst::symbols()
+    int64_t number = 0;                // the value of "const" nodes
 
-    ASTNode(std::string t, std::string v = "")
+    ASTNode(std::string_view t, std::string_view v = {})
         : type(t), value(v) {}
 };
+
+static_assert(std::is_trivially_destructible_v<ASTNode>,
+              "the arena frees nodes without destroying them");
@@ -0,0 +1,289 @@
+#include "AstFile.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "SourceBuffer.h"
+
+
+namespace {
+
+constexpr char Magic[8] = {'T', 'I', 'N', 'Y', 'A', 'S', 'T', '\0'};
+constexpr uint32_t ByteOrderMark = 0x01020304;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t sourceLength;
+    uint64_t sourceHash;
+    uint32_t nodeCount;
+    uint32_t root;
+    uint32_t literalCount;
+    uint32_t nameCount;
+    uint32_t diagnosticCount;
+    uint32_t unused;
+    uint64_t literalBytes;
+    uint64_t nameBytes;
+    uint64_t diagnosticBytes;
+};
+
+// A FlatNode as stored, with the padding spelled out so files are byte
+// for byte reproducible
+struct StoredNode {
+    uint8_t kind;
+    uint8_t op;
+    uint16_t unused;
+    uint32_t firstChild;
+    uint32_t nextSibling;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t payload;
+};
+
+static_assert(sizeof(StoredNode) == sizeof(FlatNode), "stored nodes mirror FlatNode");
+
+// FNV-1a over the whole text
+uint64_t hashSource(std::string_view source) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : source)
+        h = (h ^ c) * 1099511628211ull;
+    return h;
+}
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// Small negative numbers get small codes too: 0, -1, 1, -2, ... → 0, 1, 2, 3, ...
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t code) {
+    return static_cast<int64_t>(code >> 1) ^ -static_cast<int64_t>(code & 1);
+}
+
+size_t padding(size_t bytes) {
+    return (8 - bytes % 8) % 8;
+}
+
+void writeSection(std::ofstream& out, const void* data, size_t bytes) {
+    static const char zeros[8] = {};
+    out.write(static_cast<const char*>(data), bytes);
+    out.write(zeros, padding(bytes));
+}
+
+[[noreturn]] void fail(const std::string& filename, const std::string& problem) {
+    throw std::runtime_error("Error: AST file '" + filename + "' " + problem);
+}
+
+// Walks the mapped file section by section, checking every bound
+class SectionReader {
+public:
+    SectionReader(std::string_view file, const std::string& filename) : file(file), filename(filename) {}
+
+    const char* take(uint64_t bytes) {
+        if (bytes > file.length() - pos || padding(bytes) > file.length() - pos - bytes)
+            fail(filename, "is truncated");
+        const char* data = file.data() + pos;
+        pos += bytes + padding(bytes);
+        return data;
+    }
+
+private:
+    std::string_view file;
+    const std::string& filename;
+    size_t pos = 0;
+};
+
+// Reads the varints of one section
+class VarintReader {
+public:
+    VarintReader(const char* data, uint64_t bytes, const std::string& filename)
+        : next(data), end(data + bytes), filename(filename) {}
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (next == end)
+                fail(filename, "is truncated");
+            uint8_t byte = static_cast<uint8_t>(*next++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+        fail(filename, "has a bad varint");
+    }
+
+    std::string_view bytes(uint64_t count) {
+        if (count > static_cast<uint64_t>(end - next))
+            fail(filename, "is truncated");
+        std::string_view text(next, count);
+        next += count;
+        return text;
+    }
+
+    bool done() const { return next == end; }
+
+private:
+    const char* next;
+    const char* end;
+    const std::string& filename;
+};
+
+} // namespace
+
+void writeAstFile(const std::string& filename, const FlatAst& ast,
+                  const std::vector<ParseDiagnostic>& diagnostics, std::string_view source) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out.is_open())
+        throw std::runtime_error("Error: Cannot open output file '" + filename + "'");
+
+    std::vector<StoredNode> nodes(ast.size());
+    for (NodeId id = 0; id < ast.size(); id++) {
+        const FlatNode& node = ast[id];
+        nodes[id] = {static_cast<uint8_t>(node.kind), static_cast<uint8_t>(node.op), 0,
+                     node.firstChild, node.nextSibling, node.span.begin, node.span.end, node.payload};
+    }
+
+    std::string literals;
+    for (int64_t value : ast.literalPool())
+        putVarint(literals, zigzag(value));
+
+    const Interner& symbols = ast.symbols();
+    std::string names;
+    for (SymbolId id = 0; id < symbols.size(); id++) {
+        putVarint(names, symbols.name(id).length());
+        names += symbols.name(id);
+    }
+
+    std::string errors;
+    for (const ParseDiagnostic& diagnostic : diagnostics) {
+        putVarint(errors, diagnostic.offset);
+        putVarint(errors, diagnostic.message.length());
+        errors += diagnostic.message;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = AstFileVersion;
+    header.byteOrder = ByteOrderMark;
+    header.sourceLength = source.length();
+    header.sourceHash = hashSource(source);
+    header.nodeCount = static_cast<uint32_t>(ast.size());
+    header.root = ast.root();
+    header.literalCount = static_cast<uint32_t>(ast.literalPool().size());
+    header.nameCount = static_cast<uint32_t>(symbols.size());
+    header.diagnosticCount = static_cast<uint32_t>(diagnostics.size());
+    header.literalBytes = literals.length();
+    header.nameBytes = names.length();
+    header.diagnosticBytes = errors.length();
+
+    writeSection(out, &header, sizeof(header));
+    writeSection(out, nodes.data(), nodes.size() * sizeof(StoredNode));
+    writeSection(out, literals.data(), literals.length());
+    writeSection(out, names.data(), names.length());
+    writeSection(out, errors.data(), errors.length());
+
+    out.flush();
+    if (!out)
+        throw std::runtime_error("Error: Cannot write output file '" + filename + "'");
+}
+
+AstFile::AstFile(const std::string& filename) {
+    SourceBuffer file = SourceBuffer::fromFile(filename);
+    SectionReader reader(file.view(), filename);
+    if (file.size() < sizeof(Header))
+        fail(filename, "is not an AST file");
+    Header header;
+    std::memcpy(&header, reader.take(sizeof(Header)), sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+        fail(filename, "is not an AST file");
+    if (header.byteOrder != ByteOrderMark)
+        fail(filename, "was written on a machine of another byte order");
+    if (header.version != AstFileVersion)
+        fail(filename, "has version " + std::to_string(header.version) + ", expected " + std::to_string(AstFileVersion));
+    if (header.sourceLength > UINT32_MAX || header.nodeCount == NoNode)
+        fail(filename, "is inconsistent");
+    sourceLength = header.sourceLength;
+    sourceHash = header.sourceHash;
+
+    // Every varint takes a byte at least, so the counts are bounded by the sizes
+    if (header.nodeCount > (file.size() - sizeof(Header)) / sizeof(StoredNode) ||
+        header.literalCount > header.literalBytes || header.nameCount > header.nameBytes ||
+        header.diagnosticCount > header.diagnosticBytes)
+        fail(filename, "is truncated");
+    const char* stored = reader.take(uint64_t{header.nodeCount} * sizeof(StoredNode));
+    VarintReader literalCodes(reader.take(header.literalBytes), header.literalBytes, filename);
+    VarintReader nameCodes(reader.take(header.nameBytes), header.nameBytes, filename);
+    VarintReader errorCodes(reader.take(header.diagnosticBytes), header.diagnosticBytes, filename);
+
+    std::vector<int64_t> literals(header.literalCount);
+    for (int64_t& value : literals)
+        value = unzigzag(literalCodes.varint());
+
+    Interner names;
+    for (uint32_t k = 0; k < header.nameCount; k++) {
+        std::string_view name = nameCodes.bytes(nameCodes.varint());
+        if (name.empty() || names.intern(name) != k)
+            fail(filename, "has a bad symbol table");     // empty, or listed twice
+    }
+
+    for (uint32_t k = 0; k < header.diagnosticCount; k++) {
+        uint64_t offset = errorCodes.varint();
+        std::string_view message = errorCodes.bytes(errorCodes.varint());
+        if (offset > header.sourceLength)
+            fail(filename, "has a bad diagnostic");
+        parsed.diagnostics.push_back({static_cast<uint32_t>(offset), std::string(message)});
+    }
+    if (!literalCodes.done() || !nameCodes.done() || !errorCodes.done())
+        fail(filename, "is inconsistent");
+
+    // The tree walkers trust every link, name and literal, and that no node
+    // is reached twice (so there are no cycles), so check that once
+    const NodeId count = header.nodeCount;
+    std::vector<FlatNode> nodes(count);
+    std::vector<bool> linked(count);
+    auto link = [&](NodeId target) {
+        if (target == NoNode)
+            return;
+        if (target >= count || linked[target])
+            fail(filename, "has a bad node link");
+        linked[target] = true;
+    };
+    for (NodeId id = 0; id < count; id++) {
+        StoredNode node;
+        std::memcpy(&node, stored + size_t{id} * sizeof(StoredNode), sizeof(StoredNode));
+        if (node.kind > static_cast<uint8_t>(NodeKind::Id) || node.op > static_cast<uint8_t>(OpKind::Divide))
+            fail(filename, "has a bad node kind");
+        if (node.begin > node.end || node.end > header.sourceLength)
+            fail(filename, "has a node outside the source");
+
+        FlatNode& flat = nodes[id];
+        flat.kind = static_cast<NodeKind>(node.kind);
+        flat.op = static_cast<OpKind>(node.op);
+        flat.firstChild = node.firstChild;
+        flat.nextSibling = node.nextSibling;
+        flat.span = {node.begin, node.end};
+        flat.payload = node.payload;
+        link(node.firstChild);
+        link(node.nextSibling);
+
+        bool named = flat.kind == NodeKind::Assign || flat.kind == NodeKind::Read || flat.kind == NodeKind::Id;
+        if ((named && node.payload >= header.nameCount) ||
+            (flat.kind == NodeKind::Const && node.payload >= header.literalCount))
+            fail(filename, "has a bad node payload");
+    }
+    if (header.root != NoNode && (header.root >= count || linked[header.root]))
+        fail(filename, "has a bad root");
+
+    parsed.ast = FlatAst(std::move(nodes), std::move(literals), std::move(names), header.root);
+}
+
+bool AstFile::isFor(std::string_view source) const {
+    return source.length() == sourceLength && hashSource(source) == sourceHash;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FlatAst.h"
+#include "Parser.h"
+
+// =======================
+//     AST Files (.ast)
+// =======================
+//
+// A parsed program saved to disk, so later tools can load the tree instead
+// of scanning and parsing the source again:
+//
+//   header      magic "TINYAST\0", format version, byte-order mark, counts,
+//               and the length and FNV-1a hash of the parsed source
+//   nodes       24 bytes per node: kind, op, 2 zero bytes, then first
+//               child, next sibling, span begin, span end and payload as
+//               uint32_t; the FlatNode layout, written field by field
+//   literals    zigzag varint per number literal
+//   names       varint length, then the bytes, per symbol in ID order
+//   diagnostics varint offset, varint length, then the message, per error
+//
+// Every section starts on an 8-byte boundary. Numbers are in the byte
+// order of the machine that wrote the file; a file from a machine of the
+// other byte order is rejected rather than converted. Varints are LEB128:
+// 7 bits a byte, low bits first.
+constexpr uint32_t AstFileVersion = 1;
+
+// Writes the parse of `source` (Parser::parse() and Parser::diagnostics(),
+// or parseParallel()). Throws std::runtime_error if the file cannot be
+// written.
+void writeAstFile(const std::string& filename, const FlatAst& ast,
+                  const std::vector<ParseDiagnostic>& diagnostics, std::string_view source);
+
+// An AST file read back through a memory mapping. The node array is read
+// straight out of the mapping into one block; only the literals, names and
+// messages are decoded one by one.
+class AstFile {
+public:
+    // Throws std::runtime_error if the file cannot be read, is not an AST
+    // file, has another version or byte order, or is inconsistent.
+    explicit AstFile(const std::string& filename);
+
+    const FlatAst& ast() const { return parsed.ast; }
+    const std::vector<ParseDiagnostic>& diagnostics() const { return parsed.diagnostics; }
+
+    // Whether the tree was parsed from `source`, so it can stand in for
+    // parsing it again
+    bool isFor(std::string_view source) const;
+
+private:
+    ParseResult parsed;
+    uint64_t sourceLength = 0;
+    uint64_t sourceHash = 0;
+};
@@ -0,0 +1,116 @@
+#include "EditorText.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Whether the document breaks the line at this unit
+bool breaksLine(char16_t unit) {
+    return unit == u'\n' || unit == 0x2028 || unit == 0x2029 || unit == 0xFDD0 || unit == 0xFDD1;
+}
+
+// One byte per UTF-16 unit of `document`: '\n' where it breaks the line.
+// A LineIndex over it counts in document positions.
+std::string lineShadow(std::u16string_view document) {
+    std::string shadow(document.size(), ' ');
+    for (size_t k = 0; k < document.size(); k++)
+        if (breaksLine(document[k]))
+            shadow[k] = '\n';
+    return shadow;
+}
+
+// UTF-16 units in the UTF-8 text `bytes`: one per character, two for one
+// outside the Basic Multilingual Plane (a 4-byte sequence)
+size_t utf16Length(std::string_view bytes) {
+    size_t units = 0;
+    for (unsigned char c : bytes) {
+        if ((c & 0xC0) != 0x80) units++;
+        if (c >= 0xF0) units++;
+    }
+    return units;
+}
+
+// Bytes at the start of the UTF-8 text `bytes` that make up its first
+// `units` UTF-16 units, or npos if it is shorter than that
+size_t utf8Length(std::string_view bytes, size_t units) {
+    size_t at = 0;
+    for (; units > 0; units--) {
+        if (at == bytes.size()) return std::string_view::npos;
+        unsigned char lead = static_cast<unsigned char>(bytes[at]);
+        if (lead >= 0xF0 && units > 1) units--;
+        at++;
+        while (at < bytes.size() && (static_cast<unsigned char>(bytes[at]) & 0xC0) == 0x80) at++;
+    }
+    return at;
+}
+
+} // namespace
+
+std::string EditorText::plainUtf8(std::u16string_view document) {
+    std::string bytes;
+    bytes.reserve(document.size());
+    for (size_t k = 0; k < document.size(); k++) {
+        char32_t c = document[k];
+        if (breaksLine(document[k])) {
+            c = '\n';
+        } else if (c == 0x00A0) {
+            c = ' ';
+        } else if (c >= 0xD800 && c < 0xDC00 && k + 1 < document.size() &&
+                   document[k + 1] >= 0xDC00 && document[k + 1] < 0xE000) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (document[++k] - 0xDC00);
+        } else if (c >= 0xD800 && c < 0xE000) {
+            c = 0xFFFD;                                 // a lone surrogate, as QString::toUtf8() has it
+        }
+
+        if (c < 0x80) {
+            bytes += static_cast<char>(c);
+        } else if (c < 0x800) {
+            bytes += static_cast<char>(0xC0 | c >> 6);
+            bytes += static_cast<char>(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            bytes += static_cast<char>(0xE0 | c >> 12);
+            bytes += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+            bytes += static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            bytes += static_cast<char>(0xF0 | c >> 18);
+            bytes += static_cast<char>(0x80 | (c >> 12 & 0x3F));
+            bytes += static_cast<char>(0x80 | (c >> 6 & 0x3F));
+            bytes += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return bytes;
+}
+
+void EditorText::setText(std::u16string_view document) {
+    parsed.setText(plainUtf8(document));
+    unitLines.assign(lineShadow(document));
+    units = document.size();
+}
+
+void EditorText::edit(size_t position, size_t removedUnits, std::u16string_view inserted) {
+    if (position > units)
+        throw std::out_of_range("EditorText::edit: position past the end of the text");
+    removedUnits = std::min(removedUnits, units - position);
+
+    uint32_t offset = offsetOf(position);
+    uint32_t end = offsetOf(position + removedUnits);
+    parsed.edit(offset, end - offset, plainUtf8(inserted));
+    unitLines.edit(position, removedUnits, lineShadow(inserted));
+    units = units - removedUnits + inserted.size();
+}
+
+uint32_t EditorText::offsetOf(size_t position) const {
+    SourceLocation location = unitLines.locate(static_cast<uint32_t>(std::min(position, units)));
+    uint32_t lineStart = parsed.lexer().lines().lineStart(location.line);
+    std::string_view line = std::string_view(text()).substr(lineStart);
+    size_t bytes = utf8Length(line, location.column - 1);
+    return lineStart + static_cast<uint32_t>(bytes == std::string_view::npos ? line.size() : bytes);
+}
+
+size_t EditorText::positionOf(uint32_t offset) const {
+    const LineIndex& lines = parsed.lexer().lines();
+    offset = std::min(offset, static_cast<uint32_t>(text().size()));
+    SourceLocation location = lines.locate(offset);
+    uint32_t lineStart = lines.lineStart(location.line);
+    return unitLines.lineStart(location.line) + utf16Length(std::string_view(text()).substr(lineStart, offset - lineStart));
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "IncrementalParser.h"
+#include "LineIndex.h"
+
+// =======================
+//       Editor Text
+// =======================
+//
+// Keeps an IncrementalParser in step with a text editor's document, which
+// holds UTF-16 and counts positions in UTF-16 units (as QTextDocument
+// does), while the parser works on UTF-8 bytes.
+//
+// The parsed text is what the document's toPlainText() gives: paragraph
+// and line separators (U+2029, U+2028) and frame marks (U+FDD0, U+FDD1)
+// read as '\n', and no-break spaces as ' '. A line separator does not start
+// a block of the document, so block numbers are not line numbers. Instead,
+// a second LineIndex holds where the lines start in document positions, and
+// a position is converted only from the start of its line.
+class EditorText {
+public:
+    // Replaces the whole text
+    void setText(std::u16string_view document);
+
+    // Replaces `removedUnits` UTF-16 units at `position` with `inserted`,
+    // taken as the document has it (e.g. from QTextCursor::selectedText()).
+    // Throws std::out_of_range if `position` is past the end of the text.
+    void edit(size_t position, size_t removedUnits, std::u16string_view inserted);
+
+    // Length of the text in UTF-16 units
+    size_t length() const { return units; }
+
+    // Byte offset in text() of a document position, and back
+    uint32_t offsetOf(size_t position) const;
+    size_t positionOf(uint32_t offset) const;
+
+    const std::string& text() const { return parsed.text(); }
+    const IncrementalParser& parser() const { return parsed; }
+
+    // `document` in UTF-8, with the characters above replaced
+    static std::string plainUtf8(std::u16string_view document);
+
+private:
+    IncrementalParser parsed;
+    LineIndex unitLines;    // line starts in UTF-16 units
+    size_t units = 0;
+};
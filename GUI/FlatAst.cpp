@@ -0,0 +1,150 @@
+#include "FlatAst.h"
+#include <cstring>
+
+
+NodeId FlatAst::add(NodeKind kind, OpKind op) {
+    FlatNode node;
+    node.kind = kind;
+    node.op = op;
+    nodes.push_back(node);
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+NodeId FlatAst::addName(NodeKind kind, std::string_view name) {
+    NodeId id = add(kind);
+    nodes[id].payload = names->intern(name);
+    return id;
+}
+
+NodeId FlatAst::addSymbol(NodeKind kind, SymbolId symbol) {
+    NodeId id = add(kind);
+    nodes[id].payload = symbol;
+    return id;
+}
+
+NodeId FlatAst::addLiteral(int64_t value) {
+    NodeId id = add(NodeKind::Const);
+    nodes[id].payload = static_cast<uint32_t>(literals.size());
+    literals.push_back(value);
+    return id;
+}
+
+void FlatAst::appendChild(NodeId parent, NodeId child) {
+    // Apart from stmt-lists, nodes have at most three children, so walking
+    // to the last is cheap
+    NodeId* link = &nodes[parent].firstChild;
+    while (*link != NoNode)
+        link = &nodes[*link].nextSibling;
+    *link = child;
+}
+
+NodeId FlatAst::append(const FlatAst& other, NodeId first) {
+    Placement placement = place(other, first);
+    fill(other, placement);
+    return placement.base;
+}
+
+FlatAst::Placement FlatAst::place(const FlatAst& other, NodeId first) {
+    Placement placement;
+    placement.first = first;
+    placement.base = static_cast<NodeId>(nodes.size());
+    placement.literalBase = static_cast<uint32_t>(literals.size());
+
+    // Names take IDs here in the order they did there, i.e. of first use,
+    // unless both trees use one table
+    if (other.names != names) {
+        placement.symbols.resize(other.names->size());
+        for (SymbolId id = 0; id < placement.symbols.size(); id++)
+            placement.symbols[id] = names->intern(other.names->name(id));
+    }
+
+    nodes.resize(nodes.size() + (other.nodes.size() - first));
+    literals.insert(literals.end(), other.literals.begin(), other.literals.end());
+    return placement;
+}
+
+void FlatAst::fill(const FlatAst& other, const Placement& placement) {
+    const NodeId first = placement.first;
+    const NodeId base = placement.base;
+    auto renumber = [&](NodeId id) { return id == NoNode ? NoNode : id - first + base; };
+    for (NodeId id = first; id < other.nodes.size(); id++) {
+        FlatNode node = other.nodes[id];
+        node.firstChild = renumber(node.firstChild);
+        node.nextSibling = renumber(node.nextSibling);
+        if (node.kind == NodeKind::Const)
+            node.payload += placement.literalBase;
+        else if ((node.kind == NodeKind::Assign || node.kind == NodeKind::Read || node.kind == NodeKind::Id) &&
+                 !placement.symbols.empty())
+            node.payload = placement.symbols[node.payload];
+        nodes[id - first + base] = node;
+    }
+}
+
+size_t FlatAst::memoryUsage() const {
+    return nodes.capacity() * sizeof(FlatNode) + literals.capacity() * sizeof(int64_t) + names->memoryUsage();
+}
+
+namespace {
+
+// "(text)", stored in `arena`
+std::string_view parenthesized(Arena& arena, std::string_view text) {
+    char* data = static_cast<char*>(arena.allocate(text.size() + 2, 1));
+    data[0] = '(';
+    std::memcpy(data + 1, text.data(), text.size());
+    data[text.size() + 1] = ')';
+    return {data, text.size() + 2};
+}
+
+} // namespace
+
+SyntaxTree toSyntaxTree(const FlatAst& ast, std::string_view source) {
+    SyntaxTree tree;
+    Arena& arena = tree.arena();
+
+    // Every node first, then the links, so deep trees need no recursion
+    std::vector<ASTNode*> made(ast.size());
+    for (NodeId id = 0; id < ast.size(); id++) {
+        const FlatNode& flat = ast[id];
+        std::string_view value;
+        switch (flat.kind) {
+            case NodeKind::Assign:
+            case NodeKind::Read:
+            case NodeKind::Id:
+                value = parenthesized(arena, ast.name(id));
+                break;
+            case NodeKind::Const:
+                value = parenthesized(arena, source.substr(flat.span.begin, flat.span.length()));
+                break;
+            case NodeKind::Op:
+                value = parenthesized(arena, opKindSymbol(flat.op));
+                break;
+            default:
+                break;
+        }
+
+        ASTNode* node = arena.make<ASTNode>(nodeKindName(flat.kind), value);
+        node->span = flat.span;
+        if (flat.kind == NodeKind::Const)
+            node->number = ast.literal(id);
+        else if (flat.kind == NodeKind::Assign || flat.kind == NodeKind::Read || flat.kind == NodeKind::Id)
+            node->symbol = ast.symbol(id);
+        made[id] = node;
+    }
+
+    for (NodeId id = 0; id < ast.size(); id++) {
+        size_t count = 0;
+        for (NodeId child = ast[id].firstChild; child != NoNode; child = ast[child].nextSibling)
+            count++;
+        if (count == 0)
+            continue;
+        ASTNode** children = static_cast<ASTNode**>(arena.allocate(count * sizeof(ASTNode*), alignof(ASTNode*)));
+        count = 0;
+        for (NodeId child = ast[id].firstChild; child != NoNode; child = ast[child].nextSibling)
+            children[count++] = made[child];
+        made[id]->children = ChildList(children, count);
+    }
+
+    if (ast.root() != NoNode)
+        tree.setRoot(made[ast.root()]);
+    return tree;
+}
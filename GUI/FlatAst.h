@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Interner.h"
+#include "LineIndex.h"
+#include "SyntaxTree.h"
+
+// =======================
+//        Flat AST
+// =======================
+//
+// The parser's output: every node in one array, 24 bytes each, linked by
+// index (first child, next sibling) instead of by pointer. A statement
+// sequence (the program, a then or else part, a repeat body) is one
+// stmt-list node with the statements as its children, in order, so a long
+// program is a wide tree rather than a deep one. The other nodes have at
+// most three children: if = condition, then part, [else part]; repeat =
+// body, condition; assign and write = the expression; op = left, right.
+// An error node stands in for a statement the parser could not read; its
+// span covers the text skipped.
+
+enum class NodeKind : uint8_t { If, Repeat, Assign, Read, Write, Error, StmtList, Op, Const, Id };
+enum class OpKind : uint8_t { None, Less, Equal, Plus, Minus, Times, Divide };
+
+using NodeId = uint32_t;
+constexpr NodeId NoNode = UINT32_MAX;
+
+struct FlatNode {
+    NodeKind kind;
+    OpKind op = OpKind::None;
+    NodeId firstChild = NoNode;
+    NodeId nextSibling = NoNode;
+    SourceSpan span;             // as ASTNode::span
+    uint32_t payload = 0;        // SymbolId of assign, read and id; literal index of const
+};
+
+static_assert(sizeof(FlatNode) == 24, "FlatNode should stay compact");
+
+// The ASTNode::type spelling of each kind, and the source spelling of each operator
+constexpr std::string_view NodeKindNames[] = {"if", "repeat", "assign", "read", "write", "error", "stmt-list", "op", "const", "id"};
+constexpr std::string_view OpKindSymbols[] = {"", "<", "=", "+", "-", "*", "/"};
+
+constexpr std::string_view nodeKindName(NodeKind kind) { return NodeKindNames[static_cast<size_t>(kind)]; }
+constexpr std::string_view opKindSymbol(OpKind op) { return OpKindSymbols[static_cast<size_t>(op)]; }
+
+constexpr bool isStatement(NodeKind kind) { return kind <= NodeKind::Error; }
+
+class FlatAst {
+public:
+    FlatAst() = default;
+
+    // A finished tree, e.g. one read back from an AST file
+    FlatAst(std::vector<FlatNode> nodes, std::vector<int64_t> literals, Interner names, NodeId root)
+        : nodes(std::move(nodes)), literals(std::move(literals)),
+          names(std::make_shared<Interner>(std::move(names))), top(root) {}
+
+    // Names identifiers by the IDs in `table` from now on, e.g. the
+    // scanner's, so tree and tokens agree on them. Use before adding any.
+    void shareSymbols(std::shared_ptr<Interner> table) { names = std::move(table); }
+
+    NodeId add(NodeKind kind, OpKind op = OpKind::None);
+    NodeId addName(NodeKind kind, std::string_view name);   // assign, read, id
+    NodeId addSymbol(NodeKind kind, SymbolId symbol);        // same, by an ID of symbols()
+    NodeId addLiteral(int64_t value);                        // const
+
+    // Makes `child` the last child of `parent`
+    void appendChild(NodeId parent, NodeId child);
+
+    // Links `node` in after `previous`, the last child so far of its parent.
+    // Grows a stmt-list without walking it.
+    void appendAfter(NodeId previous, NodeId node) { nodes[previous].nextSibling = node; }
+
+    // Where another tree's nodes go when appended
+    struct Placement {
+        NodeId first;                   // the first node copied
+        NodeId base;                    // its ID here
+        uint32_t literalBase;
+        std::vector<SymbolId> symbols;  // IDs here of the other tree's names; empty if shared
+    };
+
+    // Copies `other`'s nodes from `first` on to the end of this tree, with
+    // their links, names and literals renumbered to match, and returns the
+    // new ID of `first`. Those nodes must only link to each other.
+    NodeId append(const FlatAst& other, NodeId first = 0);
+
+    // append() in two halves, so several trees can be copied in at once:
+    // place() makes room for the nodes and takes over the names and
+    // literals (call it in tree order), then fill() copies the nodes into
+    // their room. fill() may run concurrently for different placements.
+    Placement place(const FlatAst& other, NodeId first = 0);
+    void fill(const FlatAst& other, const Placement& placement);
+
+    // Makes room for `count` nodes in all, so appending up to that many
+    // moves nothing
+    void reserve(size_t count) { nodes.reserve(count); }
+
+    // Drops the nodes from `count` on; no node kept may link to them
+    void truncate(size_t count) { nodes.resize(count); }
+
+    FlatNode& operator[](NodeId id) { return nodes[id]; }
+    const FlatNode& operator[](NodeId id) const { return nodes[id]; }
+    size_t size() const { return nodes.size(); }
+
+    NodeId root() const { return top; }
+    void setRoot(NodeId id) { top = id; }
+
+    SymbolId symbol(NodeId id) const { return nodes[id].payload; }
+    std::string_view name(NodeId id) const { return names->name(nodes[id].payload); }
+    int64_t literal(NodeId id) const { return literals[nodes[id].payload]; }
+    const Interner& symbols() const { return *names; }
+    const std::vector<int64_t>& literalPool() const { return literals; }
+
+    // Bytes held by the node array, the literal pool and the name table
+    // (which may be shared)
+    size_t memoryUsage() const;
+
+private:
+    std::vector<FlatNode> nodes;
+    std::vector<int64_t> literals;
+    std::shared_ptr<Interner> names = std::make_shared<Interner>();
+    NodeId top = NoNode;
+};
+
+// Builds the equivalent ASTNode tree for the tree printers. `source` is the
+// parsed text, for the spelling of number literals.
+SyntaxTree toSyntaxTree(const FlatAst& ast, std::string_view source);
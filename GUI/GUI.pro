@@ -9,15 +9,43 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    AstFile.cpp \
+    EditorText.cpp \
+    FlatAst.cpp \
+    IncrementalLexer.cpp \
+    IncrementalParser.cpp \
+    Interner.cpp \
+    LineIndex.cpp \
+    ParallelParse.cpp \
+    ParallelScan.cpp \
     Parser.cpp \
     Scanner.cpp \
+    ScannerSimd.cpp \
+    SourceBuffer.cpp \
+    SyntaxTree.cpp \
+    TokenBuffer.cpp \
+    TokenFile.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
     ASTNode.h \
+    AstFile.h \
+    EditorText.h \
+    FlatAst.h \
+    IncrementalLexer.h \
+    IncrementalParser.h \
+    Interner.h \
+    Keywords.h \
+    LineIndex.h \
     Parser.h \
     Scanner.h \
+    ScannerSimd.h \
+    SourceBuffer.h \
+    SyntaxTree.h \
+    TokenBuffer.h \
+    TokenFile.h \
+    TokenStream.h \
     mainwindow.h
 
 FORMS += \
@@ -0,0 +1,195 @@
+#include "IncrementalLexer.h"
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+IncrementalLexer::IncrementalLexer(string text)
+{
+    setText(std::move(text));
+}
+
+void IncrementalLexer::setText(string text)
+{
+    source = std::move(text);
+    rescan();
+}
+
+void IncrementalLexer::rescan()
+{
+    ScanResult result = scan(source);
+    splice = {0, tokenList.size(), result.tokens.size(), 0};
+    tokenList = std::move(result.tokens);
+    settled = tokenList.size();
+    shift = 0;
+    diagnosticList = std::move(result.diagnostics);
+    lineIndex = std::move(result.lines);
+    symbolTable = std::move(result.symbols);
+    located = true;
+    lexedBytes = source.length();
+}
+
+const vector<Token> &IncrementalLexer::tokens() const
+{
+    settle(tokenList.size());
+    return tokenList;
+}
+
+const vector<ScanDiagnostic> &IncrementalLexer::diagnostics() const
+{
+    if (!located)
+    {
+        // Messages quote positions, which may have moved since they were made
+        for (ScanDiagnostic &diagnostic : diagnosticList)
+            diagnostic.message = lexErrorMessage(diagnostic.kind, source, diagnostic.offset);
+        locateDiagnostics(lineIndex, diagnosticList);
+        located = true;
+    }
+    return diagnosticList;
+}
+
+Token IncrementalLexer::token(size_t index) const
+{
+    Token token = tokenList[index];
+    token.offset = offsetOf(index);
+    if (index >= settled && token.type != TokenType::ENDFILE)
+        token.lexeme = string_view(source).substr(token.offset, token.lexeme.length());
+    return token;
+}
+
+size_t IncrementalLexer::tokenAt(uint32_t offset) const
+{
+    return partition_point(tokenList.begin(), tokenList.end(), [&](const Token &t) {
+        return offsetOf(&t - tokenList.data()) < offset;
+    }) - tokenList.begin();
+}
+
+// Re-points the lexemes of tokens[from..settled) at the current text
+void IncrementalLexer::rebase(size_t from)
+{
+    for (size_t k = from; k < settled; k++)
+    {
+        Token &token = tokenList[k];
+        if (token.type != TokenType::ENDFILE)
+            token.lexeme = string_view(source).substr(token.offset, token.lexeme.length());
+    }
+}
+
+// Offset of tokenList[index] in the current text
+uint32_t IncrementalLexer::offsetOf(size_t index) const
+{
+    const Token &token = tokenList[index];
+    return index < settled ? token.offset : static_cast<uint32_t>(token.offset + shift);
+}
+
+// Moves the boundary between exact and shifted tokens to `index`. Shifted
+// tokens keep their old lexemes, which settling points at the text again.
+void IncrementalLexer::settle(size_t index) const
+{
+    for (size_t k = settled; k < index; k++)
+    {
+        Token &token = tokenList[k];
+        token.offset = static_cast<uint32_t>(token.offset + shift);
+        if (token.type != TokenType::ENDFILE)
+            token.lexeme = string_view(source).substr(token.offset, token.lexeme.length());
+    }
+    for (size_t k = index; k < settled; k++)
+        tokenList[k].offset = static_cast<uint32_t>(tokenList[k].offset - shift);
+    settled = index;
+    if (settled == tokenList.size())
+        shift = 0;
+}
+
+void IncrementalLexer::edit(size_t offset, size_t removedLength, string_view insertedText)
+{
+    const char *oldData = source.data();
+    size_t oldLength = source.length();
+    source.replace(offset, removedLength, insertedText);
+    removedLength = min(removedLength, oldLength - offset);
+    lineIndex.edit(offset, removedLength, insertedText);
+
+    if (tokenList.empty())
+    {
+        rescan();
+        return;
+    }
+
+    const int64_t delta = static_cast<int64_t>(insertedText.length()) - static_cast<int64_t>(removedLength);
+    const size_t editEnd = offset + insertedText.length(); // in the new text
+
+    // Tokens ending right at the edit can grow ("ab" + "c"), so restart
+    // after the last token that ends strictly before it
+    auto endOf = [&](size_t k) {
+        const Token &token = tokenList[k];
+        return offsetOf(k) + (token.type == TokenType::ENDFILE ? 0 : static_cast<uint32_t>(token.lexeme.length()));
+    };
+    size_t first = partition_point(tokenList.begin(), tokenList.end(), [&](const Token &t) {
+        return endOf(&t - tokenList.data()) < offset;
+    }) - tokenList.begin();
+    size_t restart = first == 0 ? 0 : endOf(first - 1);
+    settle(first);
+
+    vector<Token> fresh;
+    size_t resume = tokenList.size(); // first old token that is reused as-is
+    size_t old = first;
+    Lexer lexer(source, *symbolTable, restart);
+    for (;;)
+    {
+        Token token = lexer.next();
+        if (token.type == TokenType::ENDFILE)
+        {
+            fresh.push_back(token);
+            break;
+        }
+
+        // Past the edit the text is unchanged, so once a token starts where
+        // an old one started, everything from there on lexes the same
+        if (token.offset >= editEnd)
+        {
+            int64_t oldStart = static_cast<int64_t>(token.offset) - delta;
+            while (old < tokenList.size() && static_cast<int64_t>(offsetOf(old)) < oldStart)
+                old++;
+            if (old < tokenList.size() && offsetOf(old) == oldStart &&
+                tokenList[old].type != TokenType::ENDFILE)
+            {
+                resume = old;
+                break;
+            }
+        }
+        fresh.push_back(token);
+    }
+    lexedBytes = (fresh.empty() ? restart : fresh.back().span().end) - restart;
+    splice = {first, resume - first, fresh.size(), delta};
+
+    // Diagnostics belong to ERROR tokens, so they are spliced the same way
+    uint32_t freshEnd = resume < tokenList.size() ? static_cast<uint32_t>(offsetOf(resume) + delta) : UINT32_MAX;
+    uint32_t staleEnd = resume < tokenList.size() ? offsetOf(resume) : UINT32_MAX;
+    auto byOffset = [](const ScanDiagnostic &d, uint32_t offset) { return d.offset < offset; };
+    auto staleBegin = lower_bound(diagnosticList.begin(), diagnosticList.end(), static_cast<uint32_t>(restart), byOffset);
+    auto kept = diagnosticList.erase(staleBegin, lower_bound(staleBegin, diagnosticList.end(), staleEnd, byOffset));
+    for (auto it = kept; it != diagnosticList.end(); ++it)
+        it->offset = static_cast<uint32_t>(it->offset + delta);
+    const vector<ScanDiagnostic> &found = lexer.diagnostics();
+    diagnosticList.insert(kept, found.begin(), lower_bound(found.begin(), found.end(), freshEnd, byOffset));
+    located = diagnosticList.empty();
+
+    // Splice the re-lexed run in place of the damaged tokens
+    size_t reused = first + fresh.size();
+    if (resume - first >= fresh.size())
+    {
+        copy(fresh.begin(), fresh.end(), tokenList.begin() + first);
+        tokenList.erase(tokenList.begin() + reused, tokenList.begin() + resume);
+    }
+    else
+    {
+        copy(fresh.begin(), fresh.begin() + (resume - first), tokenList.begin() + first);
+        tokenList.insert(tokenList.begin() + resume, fresh.begin() + (resume - first), fresh.end());
+    }
+
+    // Tokens after the edit moved by delta bytes, which they take on when
+    // they are settled. The text only moves when it outgrows its capacity.
+    settled = reused;
+    shift += delta;
+    if (source.data() != oldData)
+        rebase(0);
+}
@@ -0,0 +1,96 @@
+#ifndef INCREMENTAL_LEXER_H
+#define INCREMENTAL_LEXER_H
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Scanner.h"
+
+// =======================
+//    Incremental Lexer
+// =======================
+//
+// Owns a copy of the program text together with its tokens and keeps both
+// up to date across edits. An edit is re-lexed starting from the end of the
+// last token that lies entirely before it, and lexing stops as soon as a
+// token past the edit starts where an old token started (shifted by the
+// edit). The remaining old tokens are then reused as they are. Opening or
+// closing a '{' comment needs no special case: the lexer simply runs until
+// the token boundaries line up again, or to the end of the text.
+//
+// tokens() and diagnostics() always equal what scan(text()) would return,
+// except that symbol IDs are numbered by this lexer's own table.
+// Diagnostics are spliced along with their ERROR tokens; their line and
+// column are only worked out when diagnostics() is asked for. The line
+// index is patched on every edit rather than rebuilt.
+//
+// The tokens after an edit are not touched either. Their offsets (and
+// lexemes) share one pending shift, like the line index's, which is settled
+// when tokens() is asked for, or by the next edit as far as it needs: up to
+// its own position. token() and tokenAt() read through it instead. A run of edits then costs what the edited text costs to
+// re-lex, plus moving the text and token arrays along when their length
+// changes; nothing per token past the edit.
+class IncrementalLexer
+{
+public:
+    explicit IncrementalLexer(std::string text = "");
+
+    // Replaces the whole text and scans it from scratch
+    void setText(std::string text);
+
+    // Replaces `removedLength` bytes at `offset` with `insertedText`.
+    // Throws std::out_of_range if `offset` is past the end of the text.
+    void edit(size_t offset, size_t removedLength, std::string_view insertedText);
+
+    const std::string &text() const { return source; }
+    const std::vector<Token> &tokens() const;
+
+    // Token `index` of tokens(), and the index of the first token starting
+    // at or after `offset`, read without settling the pending shift
+    Token token(size_t index) const;
+    size_t tokenAt(uint32_t offset) const;
+    size_t tokenCount() const { return tokenList.size(); }
+
+    const std::vector<ScanDiagnostic> &diagnostics() const;
+    const LineIndex &lines() const { return lineIndex; }
+    const Interner &symbols() const { return *symbolTable; }
+
+    // The symbol table, for a tree that names its identifiers by the
+    // tokens' IDs. Replaced, not cleared, by setText().
+    const std::shared_ptr<Interner> &sharedSymbols() const { return symbolTable; }
+
+    // Bytes the lexer had to look at during the last update
+    size_t lastLexedBytes() const { return lexedBytes; }
+
+    // What the last update did to tokens(): `inserted` fresh tokens starting
+    // at `first` took the place of `removed` old ones, and every token after
+    // them moved by `shift` bytes
+    struct Splice
+    {
+        size_t first;
+        size_t removed;
+        size_t inserted;
+        int64_t shift;
+    };
+    const Splice &lastSplice() const { return splice; }
+
+private:
+    void rescan();
+    void rebase(size_t from);
+    uint32_t offsetOf(size_t index) const;
+    void settle(size_t index) const;
+
+    std::string source;
+    mutable std::vector<Token> tokenList;
+    mutable size_t settled = 0; // tokenList[settled..] are off by `shift`
+    mutable int64_t shift = 0;
+    LineIndex lineIndex;
+    std::shared_ptr<Interner> symbolTable; // only grows between setText() calls
+    mutable std::vector<ScanDiagnostic> diagnosticList;
+    mutable bool located = true;
+    size_t lexedBytes = 0;
+    Splice splice = {0, 0, 0, 0};
+};
+
+#endif // INCREMENTAL_LEXER_H
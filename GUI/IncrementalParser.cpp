@@ -0,0 +1,353 @@
+#include "IncrementalParser.h"
+#include <algorithm>
+
+
+namespace {
+
+// The index-th child of `node`, or NoNode
+NodeId childAt(const FlatAst& ast, NodeId node, size_t index) {
+    NodeId child = ast[node].firstChild;
+    for (; child != NoNode && index > 0; index--)
+        child = ast[child].nextSibling;
+    return child;
+}
+
+// Whether the grammar began a statement at `offset`, rather than the
+// program skipping stray tokens there: it did after ';', then, else and
+// repeat, and at the very start
+bool startsStatement(const IncrementalLexer& lexer, uint32_t offset) {
+    size_t k = lexer.tokenAt(offset);
+    if (k == 0)
+        return true;
+    TokenType before = lexer.token(k - 1).type;
+    return before == TokenType::SEMICOLON || before == TokenType::THEN ||
+           before == TokenType::ELSE || before == TokenType::REPEAT;
+}
+
+// Hands out the lexer's tokens from `index` on, as they are in its current
+// text, without settling their pending shift
+class LexerTokenSource : public TokenSource {
+public:
+    LexerTokenSource(const IncrementalLexer& lexer, size_t index) : lexer(lexer), index(index) {}
+
+    Token next() override {
+        Token token = lexer.token(index);
+        index = std::min(index + 1, lexer.tokenCount() - 1);
+        return token;
+    }
+
+    std::string errorMessage(const Token& errorToken) const override {
+        const ScanDiagnostic* diagnostic = findDiagnostic(lexer.diagnostics(), errorToken.offset);
+        return diagnostic ? diagnostic->message : TokenSource::errorMessage(errorToken);
+    }
+
+private:
+    const IncrementalLexer& lexer;
+    size_t index;
+};
+
+} // namespace
+
+IncrementalParser::IncrementalParser(std::string text)
+    : tokens(std::move(text)) {
+    parseAll();
+}
+
+void IncrementalParser::setText(std::string text) {
+    tokens.setText(std::move(text));
+    parseAll();
+}
+
+const FlatAst& IncrementalParser::ast() const {
+    if (!moves.empty()) {
+        // Whatever the old parses left unreachable took moves meant for the
+        // text around it; empty the spans that no longer fit the text
+        const uint32_t length = static_cast<uint32_t>(text().length());
+        for (NodeId id = 0; id < tree.size(); id++) {
+            SourceSpan& span = tree[id].span;
+            spanOf(tree, id);
+            if (span.begin > span.end || span.end > length)
+                span = {};
+        }
+        moves.clear();
+        applied.assign(tree.size(), 0);
+    }
+    return tree;
+}
+
+const std::vector<ParseDiagnostic>& IncrementalParser::diagnostics() const {
+    settleErrors(errors.size());
+    if (!worded) {
+        // Scanner messages quote positions, which may have moved since
+        for (ParseDiagnostic& diagnostic : errors)
+            if (const ScanDiagnostic* scanned = findDiagnostic(tokens.diagnostics(), diagnostic.offset))
+                diagnostic.message = scanned->message;
+        worded = true;
+    }
+    return errors;
+}
+
+// The span of node `id` of `ast`, after the moves it has not taken yet
+const SourceSpan& IncrementalParser::spanOf(FlatAst& ast, NodeId id) const {
+    SourceSpan& span = ast[id].span;
+    for (uint32_t& taken = applied[id]; taken < moves.size(); taken++) {
+        const Move& move = moves[taken];
+        if (span.begin >= move.moved)
+            span.begin = static_cast<uint32_t>(span.begin + move.shift);
+        if (span.end >= move.moved)
+            span.end = static_cast<uint32_t>(span.end + move.shift);
+    }
+    return span;
+}
+
+// Moves the boundary between exact and shifted diagnostics to `index`
+void IncrementalParser::settleErrors(size_t index) const {
+    for (size_t k = errorsSettled; k < index; k++)
+        errors[k].offset = static_cast<uint32_t>(errors[k].offset + errorShift);
+    for (size_t k = index; k < errorsSettled; k++)
+        errors[k].offset = static_cast<uint32_t>(errors[k].offset - errorShift);
+    errorsSettled = index;
+    if (errorsSettled == errors.size())
+        errorShift = 0;
+}
+
+void IncrementalParser::parseAll() {
+    const std::vector<Token>& list = tokens.tokens();
+    SpanTokenSource source(list.data(), list.size(), &tokens.diagnostics());
+    Parser parser(source);
+    parser.shareSymbols(tokens.sharedSymbols());
+    tree = parser.parse();
+    errors = parser.diagnostics();
+    errorsSettled = errors.size();
+    errorShift = 0;
+    worded = true;
+    freshSize = tree.size();
+    parsedTokens = list.size();
+
+    statements.clear();
+    for (NodeId x = tree[tree.root()].firstChild; x != NoNode; x = tree[x].nextSibling)
+        statements.push_back(x);
+    moves.clear();
+    applied.assign(tree.size(), 0);
+}
+
+void IncrementalParser::edit(size_t offset, size_t removedLength, std::string_view insertedText) {
+    tokens.edit(offset, removedLength, insertedText);
+    const IncrementalLexer::Splice& splice = tokens.lastSplice();
+    // Every reparse adds a stmt-list node at least, so this also bounds the
+    // moves a node can have missed
+    if (splice.first == 0 || tree.size() > 2 * freshSize) {
+        parseAll();
+        return;
+    }
+
+    // Innermost first; the whole program is the last resort
+    uint32_t restart = tokens.token(splice.first - 1).span().end;
+    std::vector<Run> runs = runsAround(restart);
+    parsedTokens = 0;
+    for (auto run = runs.rbegin(); run != runs.rend(); ++run)
+        if (reparse(*run))
+            return;
+    parseAll();
+}
+
+// The statements to reparse from for text changed at or after `offset`,
+// outermost first: in each sequence, the last statement starting before
+// `offset`, and then into the body of that statement if it holds `offset`
+std::vector<IncrementalParser::Run> IncrementalParser::runsAround(uint32_t offset) const {
+    std::vector<Run> runs;
+    size_t k = std::partition_point(statements.begin(), statements.end(), [&](NodeId x) {
+        return spanOf(tree, x).begin < offset;
+    }) - statements.begin();
+    while (k > 0 && !startsStatement(tokens, spanOf(tree, statements[k - 1]).begin))
+        k--;
+    if (k == 0)
+        return runs;
+    Run run = {NoNode, Body::Program, tree.root(), k > 1 ? statements[k - 2] : NoNode, statements[k - 1], k - 1};
+
+    for (;;) {
+        runs.push_back(run);
+
+        const FlatNode& statement = tree[run.statement];
+        if (offset >= spanOf(tree, run.statement).end)
+            break;
+        NodeId block = run.statement;
+        NodeId list = NoNode;
+        if (statement.kind == NodeKind::If) {
+            NodeId thenPart = childAt(tree, block, 1);
+            NodeId otherwise = childAt(tree, block, 2);
+            if (otherwise != NoNode && spanOf(tree, otherwise).begin < offset) {
+                list = otherwise;
+                run.body = Body::Else;
+            } else {
+                list = thenPart;
+                run.body = Body::Then;
+            }
+        } else if (statement.kind == NodeKind::Repeat &&
+                   offset < spanOf(tree, childAt(tree, block, 1)).begin) {
+            list = childAt(tree, block, 0);
+            run.body = Body::Repeat;
+        }
+        if (list == NoNode || tree[list].kind != NodeKind::StmtList)
+            break;
+
+        run = {block, run.body, list, NoNode, NoNode, 0};
+        for (NodeId x = tree[list].firstChild, previous = NoNode; x != NoNode && spanOf(tree, x).begin < offset;
+             previous = x, x = tree[x].nextSibling) {
+            if (startsStatement(tokens, tree[x].span.begin)) {
+                run.previous = previous;
+                run.statement = x;
+            }
+        }
+        if (run.statement == NoNode)
+            break;
+    }
+    return runs;
+}
+
+// Reparses from `run.statement` until the parse lines up with the old tree
+// again, and splices the result in. Leaves the tree as it was and returns
+// false if the sequence ended somewhere the old one did not.
+bool IncrementalParser::reparse(const Run& run) {
+    const IncrementalLexer::Splice& splice = tokens.lastSplice();
+    const size_t firstReused = splice.first + splice.inserted;
+    auto before = [&](uint32_t offset) { return static_cast<int64_t>(offset) - splice.shift; };
+
+    // Old spans are read as they were before this edit, which has not been
+    // added to the moves yet
+    const uint32_t restart = spanOf(tree, run.statement).begin;
+    const size_t begin = tokens.tokenAt(restart);
+    LexerTokenSource source(tokens, begin);
+    Parser parser(source);
+    parser.ast = std::move(tree);
+    parser.shareSymbols(tokens.sharedSymbols());
+    FlatAst& ast = parser.ast;
+    const size_t oldSize = ast.size();
+    auto span = [&](NodeId id) { return spanOf(ast, id); };
+
+    // Where the parse stopped, and the old statement that follows there
+    bool joined = false;
+    size_t stop = 0;
+    NodeId after = ast[run.statement].nextSibling;
+
+    parser.inBlock = run.block != NoNode;
+    parser.lastEnd = begin == 0 ? 0 : tokens.token(begin - 1).span().end;
+    parser.rejoin = [&](const Token& next) {
+        stop = tokens.tokenAt(next.offset);
+        if (stop < firstReused && next.type != TokenType::ENDFILE)
+            return false;                               // still in the re-lexed tokens
+
+        if (next.type == TokenType::SEMICOLON) {
+            int64_t start = before(tokens.token(stop + 1).offset);
+            while (after != NoNode && span(after).begin < start)
+                after = ast[after].nextSibling;
+            if (after != NoNode && span(after).begin == start)
+                return joined = true;
+            // Gone past the end of the old body: the block itself changed
+            return run.block != NoNode && before(next.offset) >= span(run.block).end;
+        }
+
+        // Any other token ends the sequence, unless it is the program's
+        // stray token, which is skipped
+        if (run.body == Body::Program && next.type != TokenType::ENDFILE)
+            return false;
+        after = NoNode;
+        switch (run.body) {
+            case Body::Program:
+                return joined = true;
+            case Body::Then:
+                if (next.type == TokenType::ELSE) {
+                    NodeId otherwise = childAt(ast, run.block, 2);
+                    joined = otherwise != NoNode && span(otherwise).begin == before(tokens.token(stop + 1).offset);
+                } else if (next.type == TokenType::END) {
+                    joined = childAt(ast, run.block, 2) == NoNode &&
+                             span(run.block).end == before(next.span().end);
+                }
+                return true;
+            case Body::Else:
+                joined = next.type == TokenType::END && span(run.block).end == before(next.span().end);
+                return true;
+            case Body::Repeat:
+                if (next.type == TokenType::UNTIL) {
+                    // The condition's span starts inside any parentheses
+                    uint32_t condition = span(childAt(ast, run.block, 1)).begin;
+                    size_t k = stop + 1;
+                    while (tokens.token(k).type == TokenType::OPENBRACKET && before(tokens.token(k).offset) < condition)
+                        k++;
+                    joined = before(tokens.token(k).offset) == condition;
+                }
+                return true;
+        }
+        return true;
+    };
+
+    parser.validateCurrent();
+    parser.call(Parser::Step::Sequence);
+    NodeId sequence = parser.run();
+    NodeId first = parser.ast[sequence].firstChild;
+    NodeId last = parser.frames.empty() ? NoNode : parser.frames.front().left;
+    parsedTokens += tokens.tokenAt(parser.currentToken().offset) - begin;
+    tree = std::move(parser.ast);
+    if (!joined) {
+        tree.truncate(oldSize);
+        return false;
+    }
+
+    // Old nodes from the stop token on moved with the text; those around
+    // the reparsed text grew or shrank with it. They take that when read.
+    const uint32_t moved = static_cast<uint32_t>(before(tokens.token(stop).offset));
+    moves.push_back({moved, splice.shift});
+    applied.resize(tree.size(), static_cast<uint32_t>(moves.size()));
+
+    // The old statements up to `after` are replaced, and become lone nodes
+    // with an empty span, as does the stmt-list the reparse put the new
+    // ones in, so the whole array stays a valid tree (for writeAstFile())
+    size_t replaced = 0;
+    for (NodeId x = run.statement; x != after; replaced++) {
+        NodeId next = tree[x].nextSibling;
+        tree[x].firstChild = NoNode;
+        tree[x].nextSibling = NoNode;
+        tree[x].span = {};
+        applied[x] = static_cast<uint32_t>(moves.size());
+        x = next;
+    }
+    tree[sequence].firstChild = NoNode;
+    tree[sequence].span = {};
+
+    // Link the new statements in their place
+    if (run.previous != NoNode)
+        tree.appendAfter(run.previous, first);
+    else
+        tree[run.list].firstChild = first;
+    tree.appendAfter(last, after);
+    if (after == NoNode) {
+        spanOf(tree, run.list);
+        tree[run.list].span.end = tree[last].span.end;
+    }
+    if (run.body == Body::Program) {
+        std::vector<NodeId> fresh;
+        for (NodeId x = first; x != after; x = tree[x].nextSibling)
+            fresh.push_back(x);
+        auto at = statements.erase(statements.begin() + run.index, statements.begin() + run.index + replaced);
+        statements.insert(at, fresh.begin(), fresh.end());
+    }
+
+    // The reparse reported everything up to and including the stop token
+    auto errorAt = [&](size_t k) {
+        return k < errorsSettled ? errors[k].offset : static_cast<uint32_t>(errors[k].offset + errorShift);
+    };
+    auto firstFrom = [&](size_t from, uint32_t offset) {
+        return std::partition_point(errors.begin() + from, errors.end(), [&](const ParseDiagnostic& d) {
+            return errorAt(&d - errors.data()) < offset;
+        }) - errors.begin();
+    };
+    size_t staleBegin = firstFrom(0, restart);
+    settleErrors(staleBegin);
+    size_t staleEnd = firstFrom(staleBegin, moved + 1);
+    errors.erase(errors.begin() + staleBegin, errors.begin() + staleEnd);
+    errors.insert(errors.begin() + staleBegin, parser.errors.begin(), parser.errors.end());
+    errorsSettled = staleBegin + parser.errors.size();
+    errorShift += splice.shift;
+    worded = errors.empty();
+    return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FlatAst.h"
+#include "IncrementalLexer.h"
+#include "Parser.h"
+
+// =======================
+//   Incremental Parser
+// =======================
+//
+// Keeps a program's text, tokens and FlatAst up to date across edits. The
+// three together are lossless: every node has its span, every token its
+// offset, and the text between tokens is the trivia.
+//
+// The tokens are patched by an IncrementalLexer. The tree is then reparsed
+// from the start of the innermost statement that begins before the
+// re-lexed tokens. That statement is looked for inside the innermost if or
+// repeat body around them. The reparse stops at the first statement
+// boundary past the edit where the old tree had one too: a ';' that is
+// followed by an old statement of the same sequence, or the token that
+// used to end the body. From there on the old subtrees are linked back in.
+// If the body ends anywhere else, the enclosing statement is reparsed
+// instead, and so on out to the whole program.
+//
+// ast() and diagnostics() always equal what Parser gives for text(), except
+// that symbol IDs are the lexer's (the tree shares its table), which only
+// grows between setText() calls. Replaced statements stay in the array as
+// lone nodes with empty spans, so the whole array is still a valid tree (it
+// can go to writeAstFile()), until it has doubled in size; the text is then
+// parsed afresh.
+//
+// Like the lexer's tokens, the nodes and diagnostics after an edit are not
+// touched by it. Each edit records how it moved the spans, and a node takes
+// the moves it missed when it is read; the diagnostics share one pending
+// shift, as the lexer's tokens do. ast() and diagnostics() settle them all.
+// The program's statements are also kept in an array, so the one to reparse
+// from is found by a binary search; inside an if or repeat body it is found
+// by a walk along the body. Besides the reparse, an edit then costs that
+// search and walk, and moving the token and statement arrays along.
+class IncrementalParser {
+public:
+    explicit IncrementalParser(std::string text = "");
+
+    // Replaces the whole text and parses it from scratch
+    void setText(std::string text);
+
+    // Replaces `removedLength` bytes at `offset` with `insertedText`.
+    // Throws std::out_of_range if `offset` is past the end of the text.
+    void edit(size_t offset, size_t removedLength, std::string_view insertedText);
+
+    const std::string& text() const { return tokens.text(); }
+    const IncrementalLexer& lexer() const { return tokens; }
+    const FlatAst& ast() const;
+    const std::vector<ParseDiagnostic>& diagnostics() const;
+
+    // Tokens the parser read during the last update
+    size_t lastParsedTokens() const { return parsedTokens; }
+
+private:
+    // Which sequence a reparse runs in
+    enum class Body : uint8_t { Program, Then, Else, Repeat };
+
+    // A statement to reparse from, and where it sits
+    struct Run {
+        NodeId block;       // the if or repeat whose body holds it, or NoNode
+        Body body;
+        NodeId list;        // the stmt-list that holds it
+        NodeId previous;    // the statement before it, or NoNode
+        NodeId statement;
+        size_t index;       // of the statement in `statements`, in the program's body
+    };
+
+    // How an edit moved the nodes that were there before it: begins and ends
+    // at or after `moved` went `shift` bytes along
+    struct Move {
+        uint32_t moved;
+        int64_t shift;
+    };
+
+    void parseAll();
+    std::vector<Run> runsAround(uint32_t offset) const;
+    bool reparse(const Run& run);
+    const SourceSpan& spanOf(FlatAst& ast, NodeId id) const;
+    void settleErrors(size_t index) const;
+
+    IncrementalLexer tokens;
+    mutable FlatAst tree;
+    std::vector<NodeId> statements;         // the program's, in order
+    mutable std::vector<Move> moves;        // not yet taken by every node
+    mutable std::vector<uint32_t> applied;  // moves taken, by node
+    mutable std::vector<ParseDiagnostic> errors;
+    mutable size_t errorsSettled = 0;       // errors[errorsSettled..] are off by `errorShift`
+    mutable int64_t errorShift = 0;
+    mutable bool worded = true;             // scanner messages quote current positions
+    size_t freshSize = 0;                   // nodes after the last full parse
+    size_t parsedTokens = 0;
+};
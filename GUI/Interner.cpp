@@ -0,0 +1,113 @@
+#include "Interner.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// FNV-1a: identifiers are short, so a byte loop beats a block hash here
+static uint32_t hashName(string_view name)
+{
+    uint32_t h = 2166136261u;
+    for (unsigned char c : name)
+        h = (h ^ c) * 16777619u;
+    return h;
+}
+
+// Slot holding `name`, or the empty slot where it would go
+size_t Interner::slotFor(string_view name, uint32_t hash) const
+{
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        const Slot &slot = slots[i];
+        if (slot.id == NoSymbol || (slot.hash == hash && names[slot.id] == name))
+            return i;
+    }
+}
+
+SymbolId Interner::find(string_view name) const
+{
+    if (slots.empty())
+        return NoSymbol;
+    return slots[slotFor(name, hashName(name))].id;
+}
+
+SymbolId Interner::intern(string_view name)
+{
+    // Keep the table at most half full
+    if ((names.size() + 1) * 2 > slots.size())
+        grow();
+
+    uint32_t hash = hashName(name);
+    size_t slot = slotFor(name, hash);
+    if (slots[slot].id != NoSymbol)
+        return slots[slot].id;
+
+    SymbolId id = static_cast<SymbolId>(names.size());
+    names.push_back(store(name));
+    slots[slot] = {hash, id};
+    return id;
+}
+
+void Interner::grow()
+{
+    vector<Slot> old(max<size_t>(64, slots.size() * 2), Slot{0, NoSymbol});
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot &slot : old)
+    {
+        if (slot.id == NoSymbol)
+            continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].id != NoSymbol)
+            i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+void Interner::clear()
+{
+    names.clear();
+    fill(slots.begin(), slots.end(), Slot{0, NoSymbol});
+    largeNames.clear();
+    blockBytes = blocks.size() * BlockSize;
+    nextBlock = 0;
+    blockUsed = BlockSize;
+}
+
+// Copies `name` into the current block, moving to the next one when it is full
+string_view Interner::store(string_view name)
+{
+    if (name.empty())
+        return {};
+    if (name.length() > BlockSize / 4)
+    {
+        // Long names get a block of their own so the shared ones stay dense
+        largeNames.push_back(make_unique<char[]>(name.length()));
+        blockBytes += name.length();
+        memcpy(largeNames.back().get(), name.data(), name.length());
+        return {largeNames.back().get(), name.length()};
+    }
+
+    if (name.length() > BlockSize - blockUsed)
+    {
+        // Blocks kept by clear() are refilled before any new one is made
+        if (nextBlock == blocks.size())
+        {
+            blocks.push_back(make_unique<char[]>(BlockSize));
+            blockBytes += BlockSize;
+        }
+        nextBlock++;
+        blockUsed = 0;
+    }
+    char *text = blocks[nextBlock - 1].get() + blockUsed;
+    memcpy(text, name.data(), name.length());
+    blockUsed += name.length();
+    return {text, name.length()};
+}
+
+size_t Interner::memoryUsage() const
+{
+    return names.capacity() * sizeof(string_view) + slots.capacity() * sizeof(Slot) +
+           (blocks.capacity() + largeNames.capacity()) * sizeof(blocks[0]) + blockBytes;
+}
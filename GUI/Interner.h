@@ -0,0 +1,71 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Dense ID of an interned identifier: 0, 1, 2, ... in order of first use
+using SymbolId = uint32_t;
+constexpr SymbolId NoSymbol = UINT32_MAX;
+
+// =======================
+//     Symbol Interner
+// =======================
+//
+// Gives each distinct identifier a SymbolId, so names can be stored as one
+// 32-bit number and compared with an integer compare. Names are copied into
+// large blocks owned by the interner (name() views stay valid as long as it
+// lives, even as it grows), and looked up through an open-addressing table
+// of IDs that keeps each name's hash beside it to skip most string compares.
+class Interner
+{
+public:
+    Interner() = default;
+    Interner(Interner &&) noexcept = default;
+    Interner &operator=(Interner &&) noexcept = default;
+    Interner(const Interner &) = delete;
+    Interner &operator=(const Interner &) = delete;
+
+    // ID of `name`, adding it if it is new
+    SymbolId intern(std::string_view name);
+
+    // ID of `name`, or NoSymbol if it was never interned
+    SymbolId find(std::string_view name) const;
+
+    std::string_view name(SymbolId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+    // Forgets every name but keeps the table and name blocks for reuse, so
+    // interning a similar set of names again allocates nothing
+    void clear();
+
+    // Bytes held by the table, the name views and the name blocks
+    size_t memoryUsage() const;
+
+private:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    size_t slotFor(std::string_view name, uint32_t hash) const;
+    void grow();
+    std::string_view store(std::string_view name);
+
+    // The hash sits next to the ID so most misses never touch the name
+    struct Slot
+    {
+        uint32_t hash;
+        SymbolId id; // NoSymbol = empty
+    };
+
+    std::vector<std::string_view> names; // by ID
+    std::vector<Slot> slots;             // size is a power of two
+    std::vector<std::unique_ptr<char[]>> blocks;     // BlockSize bytes each
+    std::vector<std::unique_ptr<char[]>> largeNames; // one oversized name each
+    size_t nextBlock = 0;                            // blocks[nextBlock - 1] is being filled
+    size_t blockUsed = BlockSize;
+    size_t blockBytes = 0;
+};
+
+#endif // INTERNER_H
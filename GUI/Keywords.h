@@ -0,0 +1,114 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include "Scanner.h"
+
+// =======================
+//    Reserved Keywords
+// =======================
+//
+// Keywords are recognized with a perfect hash over (first byte, last byte,
+// length) that is found at compile time, so a lookup is one hash and at
+// most one string compare, with no allocation and no mutable state.
+// To add a keyword, append it to keywordList; the build fails if no
+// collision-free hash parameters exist for the new set.
+
+struct Keyword
+{
+    std::string_view text;
+    TokenType type;
+};
+
+inline constexpr std::array<Keyword, 8> keywordList = {{
+    {"if", TokenType::IF},
+    {"then", TokenType::THEN},
+    {"else", TokenType::ELSE},
+    {"end", TokenType::END},
+    {"repeat", TokenType::REPEAT},
+    {"until", TokenType::UNTIL},
+    {"read", TokenType::READ},
+    {"write", TokenType::WRITE},
+}};
+
+namespace keyword_detail
+{
+constexpr std::size_t TableSize = 16; // power of two, > keywordList.size()
+
+struct HashParams
+{
+    unsigned first;
+    unsigned last;
+    bool found;
+};
+
+constexpr std::size_t hash(std::string_view word, HashParams p)
+{
+    return (static_cast<unsigned char>(word.front()) * p.first +
+            static_cast<unsigned char>(word.back()) * p.last + word.size()) &
+           (TableSize - 1);
+}
+
+constexpr HashParams findParams()
+{
+    for (unsigned first = 0; first < 64; first++)
+    {
+        for (unsigned last = 0; last < 64; last++)
+        {
+            HashParams p{first, last, true};
+            bool used[TableSize] = {};
+            bool collision = false;
+            for (const Keyword &k : keywordList)
+            {
+                std::size_t h = hash(k.text, p);
+                collision = collision || used[h];
+                used[h] = true;
+            }
+            if (!collision)
+                return p;
+        }
+    }
+    return {0, 0, false};
+}
+
+constexpr HashParams params = findParams();
+static_assert(params.found, "no perfect hash for keywordList; grow TableSize");
+
+constexpr std::array<Keyword, TableSize> makeTable()
+{
+    std::array<Keyword, TableSize> table{};
+    for (auto &slot : table)
+        slot = {"", TokenType::ID};
+    for (const Keyword &k : keywordList)
+        table[hash(k.text, params)] = k;
+    return table;
+}
+
+constexpr std::size_t maxLength()
+{
+    std::size_t longest = 0;
+    for (const Keyword &k : keywordList)
+        longest = k.text.size() > longest ? k.text.size() : longest;
+    return longest;
+}
+
+constexpr std::array<Keyword, TableSize> table = makeTable();
+constexpr std::size_t MaxLength = maxLength();
+} // namespace keyword_detail
+
+// Token type of `word` if it is a reserved keyword, otherwise TokenType::ID
+constexpr TokenType keywordType(std::string_view word)
+{
+    using namespace keyword_detail;
+    if (word.empty() || word.size() > MaxLength)
+        return TokenType::ID;
+    const Keyword &slot = table[hash(word, params)];
+    return slot.text == word ? slot.type : TokenType::ID;
+}
+
+static_assert(keywordType("until") == TokenType::UNTIL, "keyword lookup broken");
+static_assert(keywordType("x") == TokenType::ID, "keyword lookup broken");
+
+#endif // KEYWORDS_H
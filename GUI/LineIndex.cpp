@@ -0,0 +1,65 @@
+#include "LineIndex.h"
+#include "ScannerSimd.h"
+#include <algorithm>
+
+using namespace std;
+
+LineIndex::LineIndex(string_view source)
+{
+    assign(source);
+}
+
+void LineIndex::assign(string_view source)
+{
+    starts.assign(1, 0);
+    settled = SIZE_MAX;
+    shift = 0;
+    // Roughly one line per 32 bytes of typical code
+    starts.reserve(source.length() / 32 + 1);
+    scanKernels().lineStarts(source.data(), 0, source.length(), starts);
+}
+
+SourceLocation LineIndex::locate(uint32_t offset) const
+{
+    // Last line starting at or before offset
+    size_t line = partition_point(starts.begin(), starts.end(), [&](const uint32_t &lineStart) {
+        return start(&lineStart - starts.data()) <= offset;
+    }) - starts.begin() - 1;
+    return {static_cast<uint32_t>(line + 1), offset - start(line) + 1};
+}
+
+// Moves the boundary between exact and shifted starts to `index`
+void LineIndex::settle(size_t index)
+{
+    index = min(index, starts.size());
+    size_t from = min(settled, starts.size());
+    for (size_t k = from; k < index; k++)
+        starts[k] = static_cast<uint32_t>(starts[k] + shift);
+    for (size_t k = index; k < from; k++)
+        starts[k] = static_cast<uint32_t>(starts[k] - shift);
+    settled = index;
+}
+
+void LineIndex::edit(size_t offset, size_t removedLength, string_view insertedText)
+{
+    // Lines starting inside the replaced bytes go away with their newline
+    auto startsBefore = [&](size_t end) {
+        return partition_point(starts.begin(), starts.end(), [&](const uint32_t &lineStart) {
+            return start(&lineStart - starts.data()) <= end;
+        }) - starts.begin();
+    };
+    size_t first = startsBefore(offset);
+    size_t last = startsBefore(offset + removedLength);
+    settle(first);
+
+    vector<uint32_t> inserted;
+    scanKernels().lineStarts(insertedText.data(), 0, insertedText.length(), inserted);
+    for (uint32_t &lineStart : inserted)
+        lineStart += static_cast<uint32_t>(offset);
+    starts.erase(starts.begin() + first, starts.begin() + last);
+    starts.insert(starts.begin() + first, inserted.begin(), inserted.end());
+
+    // The lines after the edit moved with it
+    settled = first + inserted.size();
+    shift += static_cast<int64_t>(insertedText.length()) - static_cast<int64_t>(removedLength);
+}
@@ -0,0 +1,72 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// =======================
+//   Spans and Locations
+// =======================
+
+// Bytes [begin, end) of the source
+struct SourceSpan
+{
+    uint32_t begin = 0;
+    uint32_t end = 0;
+
+    uint32_t length() const { return end - begin; }
+};
+
+// 1-based line, and 1-based column counted in bytes
+struct SourceLocation
+{
+    uint32_t line;
+    uint32_t column;
+};
+
+// =======================
+//       Line Index
+// =======================
+//
+// Offsets of the first byte of every line, found with a vectorized newline
+// search. Turns a byte offset into a line and column with a binary search
+// instead of counting newlines from the top of the text each time.
+//
+// An edit does not touch the lines after it: they share one pending shift,
+// which is added when they are read. The next edit only settles the lines
+// between its own position and the previous one, so typing in one place
+// costs time proportional to the typed text, not to the text after it.
+class LineIndex
+{
+public:
+    LineIndex() = default; // an empty text: one line starting at 0
+    explicit LineIndex(std::string_view source);
+
+    // Re-indexes for `source`, reusing the storage already held
+    void assign(std::string_view source);
+
+    SourceLocation locate(uint32_t offset) const;
+
+    uint32_t lineCount() const { return static_cast<uint32_t>(starts.size()); }
+    // Offset of the first byte of `line` (1-based)
+    uint32_t lineStart(uint32_t line) const { return start(line - 1); }
+
+    // Keeps the index in step with replacing `removedLength` bytes at
+    // `offset` by `insertedText`, without looking at the rest of the text
+    void edit(size_t offset, size_t removedLength, std::string_view insertedText);
+
+private:
+    uint32_t start(size_t index) const
+    {
+        return index < settled ? starts[index] : static_cast<uint32_t>(starts[index] + shift);
+    }
+    void settle(size_t index);
+
+    std::vector<uint32_t> starts{0};
+    size_t settled = SIZE_MAX; // starts[settled..] are off by `shift`
+    int64_t shift = 0;
+};
+
+#endif // LINE_INDEX_H
@@ -0,0 +1,196 @@
+#include "Parser.h"
+#include <algorithm>
+#include <thread>
+
+
+// =======================
+//    Parallel Parsing
+// =======================
+//
+// A fast pre-pass picks cuts: top-level ';' tokens, near even splits of the
+// token array, where if / repeat / ( have all been closed by end / until / ).
+// The block depth at each split comes from a parallel prefix sum: every
+// thread adds up the depth changes in its share of the tokens, the sums are
+// scanned in order, and every thread then walks its share from its starting
+// depth to the first ';' at depth zero.
+//
+// Each slice is then parsed on its own thread as a top-level sequence
+// starting after its cut. Right after the grammar consumes a top-level ';',
+// its whole state is "in the program's sequence, lastEnd at the ';'", so a
+// slice that starts there parses exactly as the sequential parse would. The
+// depth count is only a guess, though (errors, and the recovery from them,
+// can close blocks elsewhere), so each slice runs until it reaches a cut as
+// the separator of the program's own sequence, and the next slice counts
+// only if it started at that cut. Starting from the first slice, that gives
+// a chain of slices that follow the sequential parse step for step; any
+// slice off the chain is thrown away, and the slice before it has already
+// parsed its text.
+//
+// The chained slices' nodes are copied into one tree in order, which
+// numbers them the way the sequential parse did, and their statements are
+// linked into one stmt-list. Every slice names its identifiers by the
+// scanner's symbol IDs, so they need no renumbering. Slices only read that
+// shared table: an ID token without a symbol (from a ScanResult not made
+// by scan()) would make Parser::addName() intern into it from several
+// threads at once. If the pre-pass finds one, every slice interns into a
+// table of its own instead, and place() renumbers their names in order.
+
+namespace {
+
+// Below this many tokens per slice a thread costs more than it saves
+constexpr size_t MinSliceTokens = 1 << 16;
+
+struct Slice {
+    size_t begin = 0;           // first token; the cut before it is begin - 1
+    FlatAst ast;                // node 0 is its stmt-list
+    std::vector<ParseDiagnostic> errors;
+    NodeId last = NoNode;       // its last top-level statement
+    size_t next = 0;            // the slice it lined up with, or the slice count at ENDFILE
+};
+
+// How a token changes the nesting depth
+int depthChange(TokenType type) {
+    switch (type) {
+        case TokenType::IF:
+        case TokenType::REPEAT:
+        case TokenType::OPENBRACKET:
+            return 1;
+        case TokenType::END:
+        case TokenType::UNTIL:
+        case TokenType::CLOSEDBRACKET:
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+// Runs work(0..count-1), one index per thread, the first on this thread
+template <typename Work>
+void runPerSlice(size_t count, Work work) {
+    std::vector<std::thread> workers;
+    workers.reserve(count);
+    for (size_t k = 1; k < count; k++)
+        workers.emplace_back(work, k);
+    work(0);
+    for (auto& worker : workers)
+        worker.join();
+}
+
+} // namespace
+
+ParseResult parseParallel(const ScanResult& scanned, unsigned threads) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const std::vector<Token>& tokens = scanned.tokens;
+    size_t wanted = std::min<size_t>(threads, tokens.size() / MinSliceTokens);
+    if (wanted <= 1 || tokens.back().type != TokenType::ENDFILE) {
+        Parser parser(scanned);
+        FlatAst ast = parser.parse();
+        return {std::move(ast), parser.diagnostics()};
+    }
+
+    // Depth at each even split, by prefix sum over the shares' depth changes
+    std::vector<size_t> splits(wanted + 1);
+    for (size_t k = 0; k <= wanted; k++)
+        splits[k] = tokens.size() * k / wanted;
+    std::vector<int64_t> depth(wanted + 1, 0);
+    std::vector<char> unnamed(wanted, false);   // an ID token without a symbol in the share
+    runPerSlice(wanted, [&](size_t k) {
+        int64_t change = 0;
+        for (size_t t = splits[k]; t < splits[k + 1]; t++) {
+            change += depthChange(tokens[t].type);
+            unnamed[k] |= tokens[t].type == TokenType::ID && tokens[t].symbol == NoSymbol;
+        }
+        depth[k + 1] = change;
+    });
+    const bool shareSymbols = std::find(unnamed.begin(), unnamed.end(), true) == unnamed.end();
+    for (size_t k = 1; k <= wanted; k++)
+        depth[k] += depth[k - 1];
+
+    // The first ';' at depth zero in each share but the first
+    std::vector<size_t> cuts(wanted, 0);
+    runPerSlice(wanted, [&](size_t k) {
+        cuts[k] = SIZE_MAX;
+        int64_t level = depth[k];
+        for (size_t t = splits[k]; k > 0 && t < splits[k + 1]; t++) {
+            if (tokens[t].type == TokenType::SEMICOLON && level == 0) {
+                cuts[k] = t;
+                break;
+            }
+            level += depthChange(tokens[t].type);
+        }
+    });
+
+    std::vector<Slice> slices(1);
+    for (size_t k = 1; k < wanted; k++)
+        if (cuts[k] != SIZE_MAX)
+            slices.emplace_back().begin = cuts[k] + 1;
+
+    // Each slice runs until it is at a later slice's cut in the program's
+    // own sequence, or at the end
+    runPerSlice(slices.size(), [&](size_t k) {
+        Slice& slice = slices[k];
+        SpanTokenSource source(tokens.data() + slice.begin, tokens.size() - slice.begin, &scanned.diagnostics);
+        Parser parser(source);
+        if (shareSymbols)
+            parser.shareSymbols(scanned.symbols);
+        parser.lastEnd = slice.begin == 0 ? 0 : tokens[slice.begin - 1].span().end;
+
+        slice.next = k + 1;
+        parser.rejoin = [&](const Token& next) {
+            if (next.type == TokenType::ENDFILE) {
+                slice.next = slices.size();
+                return true;
+            }
+            size_t at = &next - tokens.data();
+            while (slice.next < slices.size() && slices[slice.next].begin <= at)
+                slice.next++;
+            return slice.next < slices.size() && slices[slice.next].begin == at + 1;
+        };
+
+        parser.validateCurrent();
+        parser.call(Parser::Step::Sequence);
+        parser.run();
+        slice.last = parser.frames.front().left;
+        slice.ast = std::move(parser.ast);
+        slice.errors = std::move(parser.errors);
+    });
+
+    // Copy the chain into one tree: make room for every slice's nodes in
+    // order (without the stmt-list of all but the first), then copy them
+    // in on their own threads
+    std::vector<size_t> chain;
+    size_t nodes = 0;
+    for (size_t k = 0; k < slices.size(); k = slices[k].next) {
+        chain.push_back(k);
+        nodes += slices[k].ast.size();
+    }
+
+    ParseResult result;
+    FlatAst& ast = result.ast;
+    ast.shareSymbols(scanned.symbols);
+    ast.reserve(nodes);
+    std::vector<FlatAst::Placement> placements;
+    for (size_t k : chain) {
+        placements.push_back(ast.place(slices[k].ast, k == 0 ? 0 : 1));
+        result.diagnostics.insert(result.diagnostics.end(), slices[k].errors.begin(), slices[k].errors.end());
+    }
+    runPerSlice(chain.size(), [&](size_t c) {
+        ast.fill(slices[chain[c]].ast, placements[c]);
+    });
+
+    // Then link their statements into the first slice's stmt-list
+    NodeId last = slices[0].last;
+    for (size_t c = 1; c < chain.size(); c++) {
+        const Slice& slice = slices[chain[c]];
+        NodeId base = placements[c].base - 1;
+        ast.appendAfter(last, slice.ast[0].firstChild + base);
+        last = slice.last + base;
+    }
+
+    const NodeId program = 0;
+    ast[program].span = {ast[ast[program].firstChild].span.begin, ast[last].span.end};
+    ast.setRoot(program);
+    return result;
+}
@@ -0,0 +1,229 @@
+#include "Scanner.h"
+#include "ScannerSimd.h"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// =======================
+//    Parallel Scanning
+// =======================
+//
+// The input is cut into chunks right after a whitespace byte or a '}', so
+// no token can straddle a cut. The only state that can cross a cut is "inside
+// a { } comment", and that is speculated: every chunk is lexed as if it
+// started outside a comment. Had it started inside one, lexing would resume
+// right after the chunk's first '}'; since the lexer recovers from errors,
+// the outside-a-comment lex is also back at a token boundary there (the '}'
+// either closed a comment or was reported as an unexpected character), so
+// both entry states agree from that point on. A sequential pass over the
+// chunks then picks where each chunk's tokens start, and the chosen token
+// runs are concatenated.
+//
+// Each chunk interns its identifiers into a table of its own. The tables
+// are merged in chunk order, which hands out the same IDs as scan(), and
+// the tokens are renumbered while they are copied into place.
+
+namespace
+{
+// Below this many bytes per chunk a thread costs more than it saves
+constexpr size_t MinChunkSize = 1 << 16;
+
+// Dense code averages a little over 3 bytes per token; reserving for that
+// avoids regrowing each chunk's vector several times
+constexpr size_t BytesPerTokenGuess = 4;
+
+constexpr size_t NoComment = SIZE_MAX;
+
+struct Chunk
+{
+    size_t begin = 0;
+    size_t end = 0;
+
+    // Lexed as if entered outside a comment, without the trailing ENDFILE
+    vector<Token> tokens;
+    vector<ScanDiagnostic> diagnostics;
+    Interner symbols;
+    size_t openComment = NoComment; // start of a comment still open at `end`
+    size_t closeBrace = 0;          // first '}' in the chunk, or end
+
+    // Chosen by the resolution pass
+    bool skipped = false;
+    size_t firstToken = 0;
+    size_t firstDiagnostic = 0;
+    size_t outputIndex = 0;
+    vector<SymbolId> globalSymbols; // by chunk-local ID
+};
+
+void lexChunk(string_view source, Chunk &chunk)
+{
+    chunk.tokens.reserve((chunk.end - chunk.begin) / BytesPerTokenGuess);
+    // Lexing a prefix of the source keeps token views and error positions
+    // relative to the whole input
+    Lexer lexer(source.substr(0, chunk.end), chunk.symbols, chunk.begin);
+    for (;;)
+    {
+        Token token = lexer.next();
+        if (token.type == TokenType::ENDFILE)
+            break;
+        chunk.tokens.push_back(token);
+    }
+    chunk.diagnostics = lexer.takeDiagnostics();
+
+    // A comment still open at the cut is not an error unless no later chunk
+    // closes it; the resolution pass decides
+    if (!chunk.diagnostics.empty() && chunk.diagnostics.back().kind == LexError::UnclosedComment)
+    {
+        chunk.openComment = chunk.diagnostics.back().offset;
+        chunk.diagnostics.pop_back();
+        chunk.tokens.pop_back();
+    }
+
+    chunk.closeBrace = scanKernels().skipComment(source.data(), chunk.begin, chunk.end);
+}
+
+// Gives the chunk's names their IDs in `global`, in order of first use
+void mergeSymbols(Chunk &chunk, Interner &global)
+{
+    chunk.globalSymbols.assign(chunk.symbols.size(), NoSymbol);
+    if (chunk.firstToken == 0)
+    {
+        // Local IDs are already in order of first use
+        for (SymbolId id = 0; id < chunk.symbols.size(); id++)
+            chunk.globalSymbols[id] = global.intern(chunk.symbols.name(id));
+        return;
+    }
+
+    // Names first seen in the skipped (commented-out) prefix must not
+    // take an ID early
+    for (size_t k = chunk.firstToken; k < chunk.tokens.size(); k++)
+    {
+        const Token &token = chunk.tokens[k];
+        if (token.type != TokenType::ID || token.symbol == NoSymbol)
+            continue;
+        SymbolId local = token.symbol;
+        if (chunk.globalSymbols[local] == NoSymbol)
+            chunk.globalSymbols[local] = global.intern(chunk.symbols.name(local));
+    }
+}
+
+// Runs work(0..count-1), one index per thread, the first on this thread
+template <typename Work>
+void runPerChunk(size_t count, Work work)
+{
+    vector<thread> workers;
+    workers.reserve(count);
+    for (size_t k = 1; k < count; k++)
+        workers.emplace_back(work, k);
+    work(0);
+    for (auto &worker : workers)
+        worker.join();
+}
+
+bool isCutByte(char c)
+{
+    return c == '}' || c == ' ' || (c >= '\t' && c <= '\r');
+}
+} // namespace
+
+ScanResult scanParallel(string_view sourceCode, unsigned threads)
+{
+    if (threads == 0)
+        threads = max(1u, thread::hardware_concurrency());
+
+    size_t n = sourceCode.length();
+    size_t wanted = min<size_t>(threads, n / MinChunkSize);
+    if (wanted <= 1)
+        return scan(sourceCode);
+    if (n > UINT32_MAX)
+        throw length_error("Scanner Error: source is larger than 4 GiB.");
+
+    // Cut right after the first whitespace or '}' at or past each even split
+    vector<Chunk> chunks;
+    size_t begin = 0;
+    for (size_t k = 1; k < wanted; k++)
+    {
+        size_t cut = max(begin + 1, k * n / wanted);
+        while (cut < n && !isCutByte(sourceCode[cut - 1]))
+            cut++;
+        if (cut >= n)
+            break;
+        chunks.emplace_back();
+        chunks.back().begin = begin;
+        chunks.back().end = cut;
+        begin = cut;
+    }
+    chunks.emplace_back();
+    chunks.back().begin = begin;
+    chunks.back().end = n;
+
+    runPerChunk(chunks.size(), [&](size_t k) { lexChunk(sourceCode, chunks[k]); });
+
+    // Resolve the speculation front to back
+    ScanResult result;
+    size_t commentStart = NoComment;
+    size_t total = 0;
+    for (Chunk &chunk : chunks)
+    {
+        chunk.outputIndex = total;
+        if (commentStart != NoComment)
+        {
+            if (chunk.closeBrace == chunk.end)
+            {
+                chunk.skipped = true; // the comment runs through this chunk
+                continue;
+            }
+            commentStart = NoComment;
+            uint32_t resume = static_cast<uint32_t>(chunk.closeBrace + 1);
+            chunk.firstToken = partition_point(chunk.tokens.begin(), chunk.tokens.end(),
+                                               [resume](const Token &t) { return t.offset < resume; }) -
+                               chunk.tokens.begin();
+            chunk.firstDiagnostic = partition_point(chunk.diagnostics.begin(), chunk.diagnostics.end(),
+                                                    [resume](const ScanDiagnostic &d) { return d.offset < resume; }) -
+                                    chunk.diagnostics.begin();
+        }
+
+        result.diagnostics.insert(result.diagnostics.end(),
+                                  make_move_iterator(chunk.diagnostics.begin() + chunk.firstDiagnostic),
+                                  make_move_iterator(chunk.diagnostics.end()));
+        mergeSymbols(chunk, *result.symbols);
+        commentStart = chunk.openComment;
+        total += chunk.tokens.size() - chunk.firstToken;
+    }
+
+    // A comment left open at the end swallows the rest of the input; let a
+    // lexer word the error exactly as scan() would
+    Token tail = makeToken(TokenType::ENDFILE, static_cast<uint32_t>(n), "EOF");
+    if (commentStart != NoComment)
+    {
+        Lexer lexer(sourceCode, commentStart);
+        tail = lexer.next();
+        result.diagnostics.push_back(lexer.takeDiagnostics().front());
+    }
+
+    vector<Token> &tokens = result.tokens;
+    tokens.resize(total + (tail.type == TokenType::ERROR ? 2 : 1));
+    runPerChunk(chunks.size(), [&](size_t k) {
+        const Chunk &chunk = chunks[k];
+        if (chunk.skipped)
+            return;
+        auto out = tokens.begin() + chunk.outputIndex;
+        for (auto it = chunk.tokens.begin() + chunk.firstToken; it != chunk.tokens.end(); ++it, ++out)
+        {
+            *out = *it;
+            if (it->type == TokenType::ID && it->symbol != NoSymbol)
+                out->symbol = chunk.globalSymbols[it->symbol];
+        }
+    });
+    tokens[total] = tail;
+    tokens.back() = makeToken(TokenType::ENDFILE, static_cast<uint32_t>(n), "EOF");
+
+    result.lines = LineIndex(sourceCode);
+    locateDiagnostics(result.lines, result.diagnostics);
+    return result;
+}
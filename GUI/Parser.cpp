@@ -1,307 +1,499 @@
 #include "Parser.h"
-#include <stdexcept>
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 
 
-Parser::Parser(std::vector<Token> t) {
-    tokens = t;
-    currentIndex = 0;
-}
-
-
-Token Parser::currentToken() {
-    int i = tokens.size();
-    if (currentIndex >= i)
-        return {TokenType::ENDFILE, "EOF"};
-    return tokens[currentIndex];
-}
+namespace {
 
-Token Parser::peekNext() {
-    if (currentIndex + 1 >= tokens.size())
-        return {TokenType::ENDFILE, "EOF"};
-    return tokens[currentIndex + 1];
+bool endsWithEndfile(const std::vector<Token>& tokens) {
+    return !tokens.empty() && tokens.back().type == TokenType::ENDFILE;
 }
 
-void Parser::validateSequence() {
-    // We loop until size() - 1 because we are looking at i and i + 1
-    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
-        Token current = tokens[i];
-        Token next = tokens[i + 1];
-
-        // Check for ID followed by NUMBER (e.g., "min" then "123")
-        if (current.type == TokenType::ID && next.type == TokenType::NUMBER) {
-            throw std::runtime_error(
-                "Syntax Error: Consecutive tokens mismatch. Identifier '" +
-                current.lexeme + "' followed by Number '" + next.lexeme + "'"
-                );
-        }
-
-        // Check for IF followed by ELSE
-        if (current.type == TokenType::IF && next.type == TokenType::ELSE) {
-            throw std::runtime_error(
-                "Syntax Error: Forbidden sequence 'if' immediately followed by 'else'."
-                );
-        }
-
+std::vector<Token> withEndfile(std::vector<Token> tokens) {
+    if (!endsWithEndfile(tokens)) {
+        uint32_t end = tokens.empty() ? 0 : tokens.back().span().end;
+        tokens.push_back(makeToken(TokenType::ENDFILE, end, "EOF"));
     }
+    return tokens;
 }
 
-void Parser::advance() {
-    int i = tokens.size();
-    if (currentIndex < i)
-        currentIndex++;
+// Serves `tokens` in place when they end with ENDFILE
+std::unique_ptr<TokenSource> sourceFor(const std::vector<Token>& tokens,
+                                       const std::vector<ScanDiagnostic>* diagnostics = nullptr) {
+    if (endsWithEndfile(tokens))
+        return std::make_unique<SpanTokenSource>(tokens.data(), tokens.size(), diagnostics);
+    return std::make_unique<VectorTokenSource>(tokens);
 }
 
-
-void Parser::expect(TokenType type) {
-    if (currentToken().type != type) {
-        throw std::runtime_error(
-            "Syntax Error: expected " + tokenTypeToString(type) +
-            " but found " + tokenTypeToString(currentToken().type)
-        );
+// ===== Binary operators =====
+// Everything the expression parser knows about an operator. A new binary
+// operator needs an entry here (plus its OpKind), not a new grammar rule.
+struct BinaryOperator {
+    TokenType token;
+    OpKind op;
+    uint8_t precedence;     // higher binds tighter; 0 = not an operator
+    bool associative;       // left-associative; otherwise a op b op c stops after a op b
+};
+
+constexpr BinaryOperator Operators[] = {
+    {TokenType::LESSTHAN, OpKind::Less,   1, false},
+    {TokenType::EQUAL,    OpKind::Equal,  1, false},
+    {TokenType::PLUS,     OpKind::Plus,   2, true},
+    {TokenType::MINUS,    OpKind::Minus,  2, true},
+    {TokenType::MULT,     OpKind::Times,  3, true},
+    {TokenType::DIV,      OpKind::Divide, 3, true},
+};
+
+constexpr uint8_t LowestPrecedence = 1;
+constexpr uint8_t NoLimit = UINT8_MAX;
+
+// Operators indexed by token type, so a lookup is one load
+struct OperatorTable {
+    BinaryOperator byToken[std::size(TokenTypeNames)] = {};
+
+    constexpr OperatorTable() {
+        for (const BinaryOperator& entry : Operators)
+            byToken[static_cast<size_t>(entry.token)] = entry;
     }
-    advance();
-}
-
-////////////////////////////////  RULES   /////////////////////////////////////
-
-
-// exp → simple-exp [comparison-op simple-exp] 
-ASTNode* Parser::exp() {
-
-    // Parse left side (simple-exp)
-    ASTNode* left = simpleExp();
-  
-
-    // Check for optional comparison operator
-    TokenType t = currentToken().type;
-
-    if (t == TokenType::LESSTHAN || t == TokenType::EQUAL) {
-        // comparison-op node
-        std::string opSymbol = currentToken().lexeme;
-        advance();
-
-        ASTNode* compNode = new ASTNode("op", "("+opSymbol+")");
-        compNode->children.push_back(left);             // left operand
-        ASTNode* right = simpleExp();
-        compNode->children.push_back(right);            // right operand
 
-        return compNode;  // return comp-op node as root
+    constexpr const BinaryOperator& operator[](TokenType type) const {
+        return byToken[static_cast<size_t>(type)];
     }
+};
 
-    return left;
-}
-
-
-// assign-stmt → identifier := exp
-ASTNode* Parser::assignStmt() {
-    
-    // id
-    std::string idName = currentToken().lexeme;
-    expect(TokenType::ID);
+constexpr OperatorTable BinaryOperators;
 
-    // Create node for assignment
-    ASTNode* assignNode = new ASTNode("assign","("+idName+")"); 
+} // namespace
 
-    // :=
-    expect(TokenType::ASSIGN);
-
-    // exp
-    ASTNode* expr = exp();
-    assignNode->children.push_back(expr);
-
-    return assignNode;
+Parser::Parser(const std::vector<Token>& tokens)
+    : ownedSource(sourceFor(tokens)),
+      stream(*ownedSource) {
 }
 
-
-// stmt-sequence → statement { ; statement }
-ASTNode* Parser::stmtSequence() {
-
-    // Parse the first statement
-    ASTNode* first = statement();
-    ASTNode* current = first;
-
-    // Parse subsequent statements after semicolons
-    while (currentToken().type == TokenType::SEMICOLON) {
-        advance(); // consume ';'
-        ASTNode* next = statement();
-
-        // Attach next statement as a child of the previous statement
-        current->children.push_back(next);
-
-        current = next; // move forward for chaining
-    }
-
-    return first;
+Parser::Parser(std::vector<Token>&& tokens)
+    : ownedTokens(withEndfile(std::move(tokens))),
+      ownedSource(sourceFor(ownedTokens)),
+      stream(*ownedSource) {
 }
 
-
-
-
-ASTNode* Parser::program() {
-    return stmtSequence();
+Parser::Parser(const ScanResult& result)
+    : ownedSource(sourceFor(result.tokens, &result.diagnostics)),
+      stream(*ownedSource) {
+    shareSymbols(result.symbols);
 }
 
-// if-stmt → if exp then stmt-sequence [else stmt-sequence] end
-ASTNode* Parser::ifStmt() {
-    expect(TokenType::IF);
-
-    ASTNode* ifNode = new ASTNode("if");
-
-    ASTNode* cond = exp();
-    ifNode->children.push_back(cond);
-
-    expect(TokenType::THEN);
-
-    ASTNode* thenPart = stmtSequence();
-    ifNode->children.push_back(thenPart);
-
-    if (currentToken().type == TokenType::ELSE) {
-        advance();
-        ASTNode* elsePart = stmtSequence();
-        ifNode->children.push_back(elsePart);
-    }
-
-    expect(TokenType::END);
-    return ifNode;
+Parser::Parser(const TokenBuffer& tokens)
+    : ownedSource(std::make_unique<BufferTokenSource>(tokens)),
+      stream(*ownedSource) {
 }
 
-// repeat-stmt → repeat stmt-sequence until exp
-ASTNode* Parser::repeatStmt() {
-    expect(TokenType::REPEAT);
-
-    ASTNode* repeatNode = new ASTNode("repeat");
-
-    ASTNode* body = stmtSequence();
-    repeatNode->children.push_back(body);
-
-    expect(TokenType::UNTIL);
-
-    ASTNode* cond = exp();
-    repeatNode->children.push_back(cond);
-
-    return repeatNode;
+Parser::Parser(TokenSource& source)
+    : stream(source) {
 }
 
 
-// read-stmt → read identifier
-ASTNode* Parser::readStmt() {
-    expect(TokenType::READ);
-
-    std::string idName = currentToken().lexeme;
-    expect(TokenType::ID);
-
-    return new ASTNode("read", "(" + idName + ")");
+void Parser::shareSymbols(std::shared_ptr<Interner> table) {
+    ast.shareSymbols(std::move(table));
+    symbolsShared = true;
 }
 
-// write-stmt → write exp
-ASTNode* Parser::writeStmt() {
-    expect(TokenType::WRITE);
-
-    ASTNode* writeNode = new ASTNode("write");
-    ASTNode* e = exp();
-
-    writeNode->children.push_back(e);
-    return writeNode;
+// The scanner already hashed the name when it gave the token its ID
+NodeId Parser::addName(NodeKind kind, const Token& name) {
+    if (symbolsShared && name.symbol != NoSymbol)
+        return ast.addSymbol(kind, name.symbol);
+    return ast.addName(kind, name.lexeme);
 }
 
-ASTNode* Parser::statement() {
-
-    Token t = currentToken();
+// Runs whenever a new token becomes current, so every adjacent pair is
+// checked exactly once while parsing instead of in a separate pass.
+void Parser::validateCurrent() {
+    const Token& current = stream.peek(0);
 
-    switch (t.type) {
-        case TokenType::IF:     return ifStmt();
-        case TokenType::REPEAT: return repeatStmt();
-        case TokenType::ID:     return assignStmt();
-        case TokenType::READ:   return readStmt();
-        case TokenType::WRITE:  return writeStmt();
-        default:
-            throw std::runtime_error("Syntax Error: unexpected token in statement: " +
-                                     tokenTypeToString(t.type));
+    // Scanner errors arrive as ERROR tokens, which the grammar then skips
+    if (current.type == TokenType::ERROR) {
+        report(current.offset, stream.origin().errorMessage(current));
+        return;
     }
-}
 
+    const Token& next = stream.peek(1);
 
-
-
-////////////////////// EXPRESSIONS //////////////////////
-
-// term → factor { mulop factor }
-ASTNode* Parser::term() {
-    ASTNode* left = factor();
-
-    while (currentToken().type == TokenType::MULT ||
-           currentToken().type == TokenType::DIV) {
-
-        std::string op = currentToken().lexeme;
-        advance();
-
-        ASTNode* opNode = new ASTNode("op", "("+op+")");
-        opNode->children.push_back(left);
-
-        ASTNode* right = factor();
-        opNode->children.push_back(right);
-
-        left = opNode;
+    // Check for ID followed by NUMBER (e.g., "min" then "123")
+    if (current.type == TokenType::ID && next.type == TokenType::NUMBER) {
+        report(current.offset,
+            "Syntax Error: Consecutive tokens mismatch. Identifier '" +
+            std::string(current.lexeme) + "' followed by Number '" + std::string(next.lexeme) + "'"
+            );
     }
 
-    return left;
+    // Check for IF followed by ELSE
+    if (current.type == TokenType::IF && next.type == TokenType::ELSE) {
+        report(current.offset,
+            "Syntax Error: Forbidden sequence 'if' immediately followed by 'else'."
+            );
+    }
 }
 
+void Parser::advance() {
+    if (stream.peek().type == TokenType::ENDFILE)
+        return;
+    lastEnd = stream.next().span().end;
+    validateCurrent();
+}
 
-// factor → ( exp ) | number | identifier
-ASTNode* Parser::factor() {
-    Token t = currentToken();
+// Gives `node` the span from `begin` to the end of the last consumed token
+NodeId Parser::spanFrom(NodeId node, uint32_t begin) {
+    ast[node].span = {begin, lastEnd};
+    return node;
+}
 
-    if (t.type == TokenType::OPENBRACKET) {
-        advance();
-        ASTNode* e = exp();
-        expect(TokenType::CLOSEDBRACKET);
-        return e;
+// Consumes a `type` token, or reports it missing and returns false
+bool Parser::expect(TokenType type) {
+    if (currentType() != type) {
+        report(currentToken().offset,
+            "Syntax Error: expected " + tokenTypeToString(type) +
+            " but found " + tokenTypeToString(currentType())
+        );
+        return false;
     }
+    advance();
+    return true;
+}
 
-    if (t.type == TokenType::NUMBER) {
-        advance();
-        return new ASTNode("const", "(" + t.lexeme + ")");
-    }
+//////////////////////////////  ERROR RECOVERY  ///////////////////////////////
+//
+// Panic mode: when a statement cannot be read, the rest of it is skipped up
+// to a token that can follow a statement, and an error node takes its place
+// in the enclosing sequence. Each error either drops frames or consumes
+// tokens, so the parse stays linear however many errors there are.
+
+// Records an error unless one was already reported at the same token, so a
+// single mistake is not reported again by every rule that trips over it
+void Parser::report(uint32_t offset, std::string message) {
+    if (!errors.empty() && errors.back().offset == offset)
+        return;
+    errors.push_back({offset, std::move(message)});
+}
 
-    if (t.type == TokenType::ID) {
+// Skips to the next ';', or end / until / else that can close an enclosing
+// block, stepping over whole if ... end and repeat ... until blocks on the
+// way. `openBlocks` counts the blocks the abandoned statement had opened.
+void Parser::skipStatement(int openBlocks) {
+    bool nested = frames.size() > 1 || inBlock; // at the top, end / until / else close nothing
+    for (;;) {
+        switch (currentType()) {
+            case TokenType::ENDFILE:
+                return;
+            case TokenType::SEMICOLON:
+                if (openBlocks == 0)
+                    return;
+                break;
+            case TokenType::IF:
+            case TokenType::REPEAT:
+                openBlocks++;
+                break;
+            case TokenType::END:
+            case TokenType::UNTIL:
+                if (openBlocks > 0)
+                    openBlocks--;
+                else if (nested)
+                    return;
+                break;
+            case TokenType::ELSE:
+                if (openBlocks == 0 && nested)
+                    return;
+                break;
+            default:
+                break;
+        }
         advance();
-        return new ASTNode("id", "(" + t.lexeme + ")");
     }
+}
 
-    throw std::runtime_error("Syntax Error: invalid factor: " +
-                             tokenTypeToString(t.type));
+// An error node covering the text from `begin` to the last consumed token
+NodeId Parser::errorNode(uint32_t begin) {
+    NodeId node = ast.add(NodeKind::Error);
+    ast[node].span = {begin, std::max(begin, lastEnd)};
+    return node;
 }
 
+// Abandons the statement being parsed and returns the error node that
+// replaces it. Nodes already made for the statement stay in the array,
+// unreferenced.
+NodeId Parser::recover() {
+    size_t sequence = frames.size() - 1;
+    while (frames[sequence].step != Step::SequenceNext)
+        sequence--;
+
+    // An if or repeat whose end / until is still to come
+    const Frame& statement = frames[sequence + 1];
+    bool open = statement.step == Step::IfThen || statement.step == Step::IfElse ||
+                statement.step == Step::IfEnd || statement.step == Step::RepeatUntil;
+    uint32_t begin = statement.begin;
+
+    frames.resize(sequence + 1);
+    skipStatement(open ? 1 : 0);
+    return errorNode(begin);
+}
 
-// simple-exp → term { addop term }
-ASTNode* Parser::simpleExp() {
-    ASTNode* left = term();
+////////////////////////////////  RULES   /////////////////////////////////////
+//
+// The grammar runs on an explicit stack of frames instead of the native
+// call stack, so nesting depth is bounded only by memory. Each rule is cut
+// into steps at its sub-rule "calls": call() pushes the sub-rule's frame,
+// and when a rule is done it leaves its node in `result`, pops its frame,
+// and the frame below resumes at the step it saved. The steps run in the
+// same order as the recursive descent they replace, so the AST and the
+// first error reported are the same. Where a rule finds an error it calls
+// recover(), which unwinds to the innermost sequence.
+
+// Starts sub-rule `step` on top of the current frame. The caller's frame
+// reference is invalid afterwards.
+void Parser::call(Step step, uint8_t minPrecedence) {
+    frames.push_back({step, minPrecedence, NoLimit, NoNode, NoNode, 0});
+}
 
-    while (currentToken().type == TokenType::PLUS ||
-           currentToken().type == TokenType::MINUS) {
+NodeId Parser::program() {
+    frames.clear();
+    call(Step::Sequence);
+    return run();
+}
 
-        std::string op = currentToken().lexeme;
-        advance();
+// Runs the frames until the bottom one is done, or `rejoin` stops it
+NodeId Parser::run() {
+    NodeId result = NoNode;
+    while (!frames.empty()) {
+        Frame& f = frames.back();
+        switch (f.step) {
+
+        // stmt-sequence → statement { ; statement }
+        case Step::Sequence:
+            f.node = ast.add(NodeKind::StmtList);
+            f.step = Step::SequenceNext;
+            call(Step::Statement);
+            break;
+
+        case Step::SequenceNext:
+            if (f.left == NoNode)
+                ast.appendChild(f.node, result);    // the first statement
+            else
+                ast.appendAfter(f.left, result);
+            f.left = result;
+            if (frames.size() == 1 && rejoin && rejoin(currentToken()))
+                return f.node;
+            if (currentType() == TokenType::SEMICOLON) {
+                advance(); // consume ';'
+                call(Step::Statement);
+            } else if (frames.size() == 1 && !inBlock && currentType() != TokenType::ENDFILE) {
+                // Only the end of the input ends the program
+                uint32_t begin = currentToken().offset;
+                report(begin, "Syntax Error: expected SEMICOLON but found " +
+                              tokenTypeToString(currentType()));
+                skipStatement(0);
+                result = errorNode(begin);          // listed on the next pass
+            } else {
+                ast[f.node].span = {ast[ast[f.node].firstChild].span.begin, ast[f.left].span.end};
+                result = f.node;
+                frames.pop_back();
+            }
+            break;
+
+        case Step::Statement:
+            f.begin = currentToken().offset;
+            switch (currentType()) {
+                case TokenType::IF:     f.step = Step::If; break;
+                case TokenType::REPEAT: f.step = Step::Repeat; break;
+                case TokenType::ID:     f.step = Step::Assign; break;
+                case TokenType::READ:   f.step = Step::Read; break;
+                case TokenType::WRITE:  f.step = Step::Write; break;
+                default:
+                    report(f.begin, "Syntax Error: unexpected token in statement: " +
+                                    tokenTypeToString(currentType()));
+                    result = recover();
+            }
+            break;
+
+        // if-stmt → if exp then stmt-sequence [else stmt-sequence] end
+        case Step::If:
+            advance(); // consume 'if'
+            f.node = ast.add(NodeKind::If);
+            f.step = Step::IfThen;
+            call(Step::Exp, LowestPrecedence);
+            break;
+
+        case Step::IfThen:
+            ast.appendChild(f.node, result);
+            if (!expect(TokenType::THEN)) {
+                result = recover();
+                break;
+            }
+            f.step = Step::IfElse;
+            call(Step::Sequence);
+            break;
+
+        case Step::IfElse:
+            ast.appendChild(f.node, result);
+            if (currentType() == TokenType::ELSE) {
+                advance();
+                f.step = Step::IfEnd;
+                call(Step::Sequence);
+                break;
+            }
+            if (!expect(TokenType::END)) {
+                result = recover();
+                break;
+            }
+            result = spanFrom(f.node, f.begin);
+            frames.pop_back();
+            break;
+
+        case Step::IfEnd:
+            ast.appendChild(f.node, result);
+            if (!expect(TokenType::END)) {
+                result = recover();
+                break;
+            }
+            result = spanFrom(f.node, f.begin);
+            frames.pop_back();
+            break;
+
+        // repeat-stmt → repeat stmt-sequence until exp
+        case Step::Repeat:
+            advance(); // consume 'repeat'
+            f.node = ast.add(NodeKind::Repeat);
+            f.step = Step::RepeatUntil;
+            call(Step::Sequence);
+            break;
+
+        case Step::RepeatUntil:
+            ast.appendChild(f.node, result);
+            if (!expect(TokenType::UNTIL)) {
+                result = recover();
+                break;
+            }
+            f.step = Step::LastChild;
+            call(Step::Exp, LowestPrecedence);
+            break;
+
+        // assign-stmt → identifier := exp
+        case Step::Assign:
+            f.node = addName(NodeKind::Assign, currentToken());
+            advance(); // consume the identifier
+            if (!expect(TokenType::ASSIGN)) {
+                result = recover();
+                break;
+            }
+            f.step = Step::LastChild;
+            call(Step::Exp, LowestPrecedence);
+            break;
+
+        // read-stmt → read identifier
+        case Step::Read: {
+            advance(); // consume 'read'
+            Token name = currentToken();
+            if (!expect(TokenType::ID)) {
+                result = recover();
+                break;
+            }
+            result = spanFrom(addName(NodeKind::Read, name), f.begin);
+            frames.pop_back();
+            break;
+        }
 
-        ASTNode* opNode = new ASTNode("op", "("+op+")");
-        opNode->children.push_back(left);
+        // write-stmt → write exp
+        case Step::Write:
+            advance(); // consume 'write'
+            f.node = ast.add(NodeKind::Write);
+            f.step = Step::LastChild;
+            call(Step::Exp, LowestPrecedence);
+            break;
+
+        // A statement's trailing exp has been parsed
+        case Step::LastChild:
+            ast.appendChild(f.node, result);
+            result = spanFrom(f.node, f.begin);
+            frames.pop_back();
+            break;
+
+        ////////////////////// EXPRESSIONS //////////////////////
+        //
+        // Precedence climbing over the BinaryOperators table:
+        //   exp(min) → operand { op exp(precedence(op) + 1) }
+        // taking only operators of precedence `min` or more. That gives the
+        // same left-leaning op trees as the old chain of
+        //   exp → simple-exp [comparison-op simple-exp]
+        //   simple-exp → term { addop term }
+        //   term → factor { mulop factor }
+        // with one frame per operand instead of four.
+
+        // operand → ( exp ) | number | identifier
+        case Step::Exp: {
+            const Token& t = currentToken();
+            uint32_t begin = t.offset;
+
+            if (t.type == TokenType::OPENBRACKET) {
+                advance();
+                f.step = Step::ExpClose;
+                call(Step::Exp, LowestPrecedence);
+                break;
+            }
+
+            // `t` dies with advance(), so build the leaf first
+            if (t.type == TokenType::NUMBER) {
+                result = ast.addLiteral(t.value);
+            } else if (t.type == TokenType::ID) {
+                result = addName(NodeKind::Id, t);
+            } else {
+                report(begin, "Syntax Error: invalid factor: " + tokenTypeToString(t.type));
+                result = recover();
+                break;
+            }
+            advance();
+            spanFrom(result, begin);
+            f.step = Step::ExpOperator;
+            break;
+        }
 
-        ASTNode* right = term();
-        opNode->children.push_back(right);
+        case Step::ExpClose:                        // `result` is the parenthesized exp
+            if (!expect(TokenType::CLOSEDBRACKET)) {
+                result = recover();
+                break;
+            }
+            f.step = Step::ExpOperator;
+            break;
+
+        case Step::ExpOperator: {
+            const BinaryOperator& op = BinaryOperators[currentType()];
+            if (op.precedence < f.minPrecedence || op.precedence > f.maxPrecedence) {
+                frames.pop_back();                  // `result` is the whole exp
+                break;
+            }
+            f.node = ast.add(NodeKind::Op, op.op);
+            advance();
+            ast.appendChild(f.node, result);        // left operand
+            f.left = result;
+            if (!op.associative)
+                f.maxPrecedence = op.precedence - 1;
+            f.step = Step::ExpRight;
+            call(Step::Exp, op.precedence + 1);
+            break;
+        }
 
-        left = opNode; // result becomes the new left
+        case Step::ExpRight:
+            ast.appendChild(f.node, result);        // right operand
+            result = spanFrom(f.node, ast[f.left].span.begin); // result becomes the new left
+            f.step = Step::ExpOperator;
+            break;
+        }
     }
 
-    return left;
+    return result;
 }
 
 
 // ======== parse() =========
-ASTNode* Parser::parse() {
-    // Add the check here
-    validateSequence();
-    return program();
+FlatAst Parser::parse() {
+    validateCurrent();
+    ast.setRoot(program());     // reads up to ENDFILE, whatever the errors
+    return std::move(ast);
 }
-
@@ -1,39 +1,120 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 #include "Scanner.h"
-#include "ASTNode.h"
+#include "FlatAst.h"
+#include "TokenBuffer.h"
+#include "TokenStream.h"
+
+// One syntax error (or scanner error, for an ERROR token). `offset` is
+// where the offending token starts.
+struct ParseDiagnostic {
+    uint32_t offset;
+    std::string message;
+};
+
+// What Parser::parse() and Parser::diagnostics() give for a program
+struct ParseResult {
+    FlatAst ast;
+    std::vector<ParseDiagnostic> diagnostics;
+};
 
 class Parser {
 private:
-    std::vector<Token> tokens;
-    int currentIndex;
+    std::vector<Token> ownedTokens;             // set by the moving vector constructor
+    std::unique_ptr<TokenSource> ownedSource;   // set by all but the TokenSource constructor
+    TokenStream stream;
+    uint32_t lastEnd = 0;                       // end of the last consumed token
+    FlatAst ast;                                // being built
+    std::vector<ParseDiagnostic> errors;
+    bool symbolsShared = false;                 // ast names identifiers by the tokens' symbol IDs
+
+    // Valid until the next advance()
+    const Token& currentToken() { return stream.peek(0); }
+    const Token& peekNext() { return stream.peek(1); }
+    TokenType currentType() { return stream.peek(0).type; }
 
-    Token currentToken();
     void advance();
-    void expect(TokenType type);
-    Token peekNext();
-    void validateSequence();
-
-    // ===== Grammar methods =====
-    ASTNode* program();
-    ASTNode* stmtSequence();
-    ASTNode* statement();
-    ASTNode* ifStmt();
-    ASTNode* repeatStmt();
-    ASTNode* assignStmt();      // (implemented in Parser.cpp)
-    ASTNode* readStmt();
-    ASTNode* writeStmt();
-    ASTNode* exp();
-    ASTNode* simpleExp();
-    ASTNode* term();
-    ASTNode* factor();
-    ASTNode* comparisonOp();
-    ASTNode* addOp();
-    ASTNode* mulOp();
+    bool expect(TokenType type);
+    void validateCurrent();
+    NodeId spanFrom(NodeId node, uint32_t begin);
+
+    // Makes the tree share the table the tokens' symbol IDs come from
+    void shareSymbols(std::shared_ptr<Interner> table);
+    NodeId addName(NodeKind kind, const Token& name);
+
+    // ===== Error recovery =====
+    void report(uint32_t offset, std::string message);
+    void skipStatement(int openBlocks);
+    NodeId errorNode(uint32_t begin);
+    NodeId recover();
+
+    // ===== Grammar =====
+    // Where a rule resumes once its current sub-rule is done
+    enum class Step : uint8_t {
+        Sequence, SequenceNext, Statement,
+        If, IfThen, IfElse, IfEnd, Repeat, RepeatUntil, Assign, Read, Write, LastChild,
+        Exp, ExpClose, ExpOperator, ExpRight
+    };
+
+    struct Frame {
+        Step step;
+        uint8_t minPrecedence;  // for an exp, the operators it may take
+        uint8_t maxPrecedence;
+        NodeId node;        // the rule's node (the stmt-list, for a sequence)
+        NodeId left;        // left operand, or the last statement of a sequence
+        uint32_t begin;     // where the rule's text starts
+    };
+
+    std::vector<Frame> frames;  // the parse stack, on the heap
+
+    void call(Step step, uint8_t minPrecedence = 0);
+    NodeId program();
+    NodeId run();
+
+    // ===== Reparsing =====
+    // IncrementalParser runs the grammar over part of a sequence: the
+    // bottom frame is then that sequence, which may be a block's body, and
+    // `rejoin` is asked after each of its statements whether to stop there
+    friend class IncrementalParser;
+    friend ParseResult parseParallel(const ScanResult& scanned, unsigned threads);
+    bool inBlock = false;
+    std::function<bool(const Token& next)> rejoin;
 
 public:
-    Parser(std::vector<Token> t);
-    ASTNode* parse();
+    // Reads the tokens in place; `tokens` must outlive the parser. Tokens
+    // that do not end with ENDFILE are copied instead.
+    Parser(const std::vector<Token>& tokens);
+
+    // Takes over the tokens, without copying them
+    Parser(std::vector<Token>&& tokens);
+
+    // Reads result.tokens in place and reports scanner errors with the
+    // scanner's messages. `result` must outlive the parser; the tree shares
+    // its symbol table and keeps the scanner's symbol IDs. The other
+    // constructors intern the names into a table of the tree's own.
+    Parser(const ScanResult& result);
+
+    // Reads the tokens straight out of `tokens`, which must outlive the parser
+    Parser(const TokenBuffer& tokens);
+
+    // Pulls tokens from `source` while parsing (e.g. a Lexer, so scanning
+    // and parsing run as one pass). `source` must outlive the parser.
+    Parser(TokenSource& source);
+
+    // Parses the whole input. Can be called once. Errors do not stop the
+    // parse: each is listed in diagnostics() and the statement it spoiled
+    // becomes an error node. toSyntaxTree() turns the result into ASTNodes.
+    FlatAst parse();
+
+    // Every error found by parse(), in source order
+    const std::vector<ParseDiagnostic>& diagnostics() const { return errors; }
 };
+
+// Same tree and errors as Parser(scanned).parse(), node for node, but a
+// large program's top-level statements are split among `threads` worker
+// threads (0 = one per hardware thread). `scanned` must outlive the call.
+ParseResult parseParallel(const ScanResult& scanned, unsigned threads = 0);
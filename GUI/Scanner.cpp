@@ -1,99 +1,196 @@
 #include "Scanner.h"
+#include "Keywords.h"
+#include "ScannerSimd.h"
+#include "SourceBuffer.h"
 #include <iostream>
 #include <string>
 #include <vector>
-#include <cctype>
-#include <map>
+#include <array>
+#include <algorithm>
+#include <charconv>
+#include <system_error>
+#include <cstdint>
 #include <fstream>
-#include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
 
 
-// Map of reserved keywords
-map<string, TokenType> reservedKeywords = {
-    {"if", TokenType::IF},
-    {"then", TokenType::THEN},
-    {"else", TokenType::ELSE},
-    {"end", TokenType::END},
-    {"repeat", TokenType::REPEAT},
-    {"until", TokenType::UNTIL},
-    {"read", TokenType::READ},
-    {"write", TokenType::WRITE}};
+// =======================
+//   Lexer DFA Tables
+// =======================
+//
+// Every byte is mapped to a character class, and the DFA moves on
+// (state, class). Both tables are built at compile time, so the scanner
+// does one class lookup and one transition lookup per byte.
 
-// Helper function to print token type (for demonstration)
-string tokenTypeToString(TokenType type)
+namespace
+{
+enum CharClass : uint8_t
+{
+    CC_SPACE,  // isspace() in the C locale
+    CC_ALPHA,  // a-z A-Z
+    CC_DIGIT,  // 0-9
+    CC_COLON,  // ':'
+    CC_EQUAL,  // '=' (also the second half of ':=')
+    CC_SYMBOL, // ; < + - * / ( )
+    CC_LBRACE, // '{'
+    CC_RBRACE, // '}'
+    CC_OTHER,
+    CC_COUNT
+};
+
+// DFA states first, then the actions a transition can request.
+// Actions leave the DFA back in S_START.
+enum DfaStep : uint8_t
+{
+    S_START,
+    S_ID,
+    S_NUMBER,
+    S_COLON,
+    S_COMMENT,
+    S_COUNT,
+
+    A_EMIT_WORD = S_COUNT, // identifier or keyword ends before this byte
+    A_EMIT_NUMBER,         // number ends before this byte
+    A_EMIT_ASSIGN,         // this byte completes ':='
+    A_EMIT_SYMBOL,         // this byte is a one-character token
+    A_ERROR_COLON,         // ':' not followed by '='
+    A_ERROR_CHAR           // byte cannot start a token
+};
+
+constexpr array<uint8_t, 256> makeCharClasses()
+{
+    array<uint8_t, 256> classes{};
+    for (auto &c : classes)
+        c = CC_OTHER;
+    for (unsigned char c : {' ', '\t', '\n', '\v', '\f', '\r'})
+        classes[c] = CC_SPACE;
+    for (int c = 'a'; c <= 'z'; c++)
+        classes[c] = CC_ALPHA;
+    for (int c = 'A'; c <= 'Z'; c++)
+        classes[c] = CC_ALPHA;
+    for (int c = '0'; c <= '9'; c++)
+        classes[c] = CC_DIGIT;
+    for (unsigned char c : {';', '<', '+', '-', '*', '/', '(', ')'})
+        classes[c] = CC_SYMBOL;
+    classes[':'] = CC_COLON;
+    classes['='] = CC_EQUAL;
+    classes['{'] = CC_LBRACE;
+    classes['}'] = CC_RBRACE;
+    return classes;
+}
+
+constexpr array<TokenType, 256> makeSymbolTokens()
 {
-    switch (type)
+    array<TokenType, 256> types{};
+    for (auto &t : types)
+        t = TokenType::ERROR;
+    types[';'] = TokenType::SEMICOLON;
+    types['<'] = TokenType::LESSTHAN;
+    types['='] = TokenType::EQUAL;
+    types['+'] = TokenType::PLUS;
+    types['-'] = TokenType::MINUS;
+    types['*'] = TokenType::MULT;
+    types['/'] = TokenType::DIV;
+    types['('] = TokenType::OPENBRACKET;
+    types[')'] = TokenType::CLOSEDBRACKET;
+    return types;
+}
+
+using DfaTable = array<array<uint8_t, CC_COUNT>, S_COUNT>;
+
+constexpr DfaTable makeDfa()
+{
+    DfaTable dfa{};
+
+    auto &start = dfa[S_START];
+    start[CC_SPACE] = S_START;
+    start[CC_ALPHA] = S_ID;
+    start[CC_DIGIT] = S_NUMBER;
+    start[CC_COLON] = S_COLON;
+    start[CC_EQUAL] = A_EMIT_SYMBOL;
+    start[CC_SYMBOL] = A_EMIT_SYMBOL;
+    start[CC_LBRACE] = S_COMMENT;
+    start[CC_RBRACE] = A_ERROR_CHAR;
+    start[CC_OTHER] = A_ERROR_CHAR;
+
+    for (int c = 0; c < CC_COUNT; c++)
     {
-    case TokenType::IF:
-        return "IF";
-    case TokenType::THEN:
-        return "THEN";
-    case TokenType::ELSE:
-        return "ELSE";
-    case TokenType::END:
-        return "END";
-    case TokenType::REPEAT:
-        return "REPEAT";
-    case TokenType::UNTIL:
-        return "UNTIL";
-    case TokenType::READ:
-        return "READ";
-    case TokenType::WRITE:
-        return "WRITE";
-    case TokenType::SEMICOLON:
-        return "SEMICOLON";
-    case TokenType::ASSIGN:
-        return "ASSIGN";
-    case TokenType::ID:
-        return "ID";
-    case TokenType::ENDFILE:
-        return "ENDFILE";
-    case TokenType::ERROR:
-        return "ERROR";
-    case TokenType::LESSTHAN:
-        return "LESSTHAN";
-    case TokenType::EQUAL:
-        return "EQUAL";
-    case TokenType::PLUS:
-        return "PLUS";
-    case TokenType::MINUS:
-        return "MINUS";
-    case TokenType::MULT:
-        return "MULT";
-    case TokenType::DIV:
-        return "DIV";
-    case TokenType::OPENBRACKET:
-        return "OPENBRACKET";
-    case TokenType::CLOSEDBRACKET:
-        return "CLOSEDBRACKET";
-    case TokenType::NUMBER:
-        return "NUMBER";
+        dfa[S_ID][c] = A_EMIT_WORD;
+        dfa[S_NUMBER][c] = A_EMIT_NUMBER;
+        dfa[S_COLON][c] = A_ERROR_COLON;
+        dfa[S_COMMENT][c] = S_COMMENT;
+    }
+    dfa[S_ID][CC_ALPHA] = S_ID;
+    dfa[S_NUMBER][CC_DIGIT] = S_NUMBER;
+    dfa[S_COLON][CC_EQUAL] = A_EMIT_ASSIGN;
+    dfa[S_COMMENT][CC_RBRACE] = S_START;
+    return dfa;
+}
+
+constexpr array<uint8_t, 256> charClasses = makeCharClasses();
+constexpr array<TokenType, 256> symbolTokens = makeSymbolTokens();
+constexpr DfaTable dfa = makeDfa();
+
+inline uint8_t charClass(char c)
+{
+    return charClasses[static_cast<unsigned char>(c)];
+}
+
+// After stepping into `state`, jump over the rest of the run that keeps the
+// DFA in that state, using the vector kernels.
+inline size_t skipRun(const ScanKernels &kernels, uint8_t state, const char *data, size_t i, size_t n)
+{
+    switch (state)
+    {
+    case S_START:
+        return kernels.skipSpace(data, i, n);
+    case S_ID:
+        return kernels.skipAlpha(data, i, n);
+    case S_NUMBER:
+        return kernels.skipDigits(data, i, n);
+    case S_COMMENT:
+        return kernels.skipComment(data, i, n);
     default:
-        return "UNKNOWN";
+        return i;
     }
 }
+} // namespace
 
-// Global variable to store the error message
-string scannerErrorMessage = "";
+// Helper function to print token type (for demonstration)
+string tokenTypeToString(TokenType type)
+{
+    return string(tokenTypeName(type));
+}
 
-// Function to read file content into a string
+// Function to read file content into a string. On Windows CRLF line
+// endings become LF, as the text-mode ifstream used to make them there;
+// elsewhere the bytes are kept, so offsets match the file on disk.
 string readFile(const string &filename)
 {
-    ifstream file(filename);
-    if (!file.is_open())
+    SourceBuffer source = SourceBuffer::fromFile(filename);
+    string_view raw = source.view();
+#ifndef _WIN32
+    return string(raw);
+#else
+    string text;
+    text.reserve(raw.size());
+    size_t from = 0;
+    for (size_t cr = raw.find("\r\n"); cr != string_view::npos; cr = raw.find("\r\n", from))
     {
-        throw runtime_error("Error: Cannot open input file '" + filename + "'");
+        text.append(raw, from, cr - from);
+        from = cr + 1;
     }
-
-    stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    text.append(raw, from, string_view::npos);
+    return text;
+#endif
 }
 
-// Function to write tokens into output file
+// Function to write tokens into output file. Lines are collected into
+// large blocks and written a block at a time; endl used to flush the
+// stream after every token.
 void writeFile(const string &filename, const vector<Token> &tokens)
 {
     ofstream file(filename);
@@ -102,192 +199,240 @@ void writeFile(const string &filename, const vector<Token> &tokens)
         throw runtime_error("Error: Cannot open output file '" + filename + "'");
     }
 
-    file << "Tokens produced by the scanner:" << endl;
-    file << "-------------------------------" << endl;
+    constexpr size_t BlockSize = 1 << 20;
+    string block;
+    block.reserve(BlockSize + 256);
+    block += "Tokens produced by the scanner:\n";
+    block += "-------------------------------\n";
     for (const auto &token : tokens)
     {
-        file << "Lexeme: \"" << token.lexeme << "\"" << ", Type: " << tokenTypeToString(token.type) << endl;
+        block += "Lexeme: \"";
+        block += token.lexeme;
+        block += "\", Type: ";
+        block += tokenTypeName(token.type);
+        block += '\n';
+        if (block.size() >= BlockSize)
+        {
+            file.write(block.data(), block.size());
+            block.clear();
+        }
+    }
+    block += "-------------------------------\n";
+    block += "Total tokens: " + to_string(tokens.size()) + "\n";
+    file.write(block.data(), block.size());
+
+    file.flush();
+    if (!file)
+    {
+        throw runtime_error("Error: Cannot write output file '" + filename + "'");
     }
-    file << "-------------------------------" << endl;
-    file << "Total tokens: " << tokens.size() << endl;
 }
 
-// The scanner function, now stopping on error and clearing the tokens vector
-vector<Token>scan(const string &sourceCode)
+Lexer::Lexer(string_view source, size_t start)
+    : source(source), pos(start)
 {
-    vector<Token> tokens;
-    string currentLexeme;
-    int i = 0;
-    int n = sourceCode.length();
-    scannerErrorMessage = ""; // Clear previous error message
+    if (source.length() > UINT32_MAX)
+    {
+        throw length_error("Scanner Error: source is larger than 4 GiB.");
+    }
+}
 
-    while (i < n)
+Lexer::Lexer(string_view source, Interner &symbols, size_t start)
+    : Lexer(source, start)
+{
+    this->symbols = &symbols;
+}
+
+Token Lexer::make(TokenType type, size_t start, size_t length) const
+{
+    return makeToken(type, static_cast<uint32_t>(start), source.substr(start, length));
+}
+
+// Decodes the digits once, here, so nothing later has to; a literal that
+// does not fit becomes an ERROR token
+Token Lexer::number(size_t start, size_t length)
+{
+    Token token = make(TokenType::NUMBER, start, length);
+    const char *digits = token.lexeme.data();
+    if (from_chars(digits, digits + length, token.value).ec == errc::result_out_of_range)
+        return fail(LexError::NumberOverflow, start, length, start + length);
+    return token;
+}
+
+// Keyword or identifier; identifiers are interned when there is a table
+Token Lexer::word(size_t start, size_t length) const
+{
+    Token token = make(keywordType(source.substr(start, length)), start, length);
+    if (symbols && token.type == TokenType::ID)
+        token.symbol = symbols->intern(token.lexeme);
+    return token;
+}
+
+string lexErrorMessage(LexError kind, string_view source, size_t offset)
+{
+    switch (kind)
     {
-        char currentChar = sourceCode[i];
+    case LexError::BadAssign:
+        return "Scanner Error: Expected ':=' but found ':' at position " + to_string(offset) + ".";
+    case LexError::UnexpectedChar:
+        return "Scanner Error: Unexpected character '" + string(1, source[offset]) + "' at position " + to_string(offset) + ".";
+    case LexError::UnclosedComment:
+        return "Scanner Error: Unclosed comment starting at position " + to_string(offset) + ".";
+    case LexError::NumberOverflow:
+        return "Scanner Error: Number at position " + to_string(offset) + " does not fit in 64 bits.";
+    default:
+        return "";
+    }
+}
 
-        // Skip whitespace
-        if (isspace(currentChar))
-        {
-            i++;
-            continue;
-        }
+Token Lexer::fail(LexError kind, size_t offset, size_t length, size_t resume)
+{
+    errors.push_back({kind, static_cast<uint32_t>(offset), 0, 0, lexErrorMessage(kind, source, offset)});
+    pos = resume;
+    return make(TokenType::ERROR, offset, length);
+}
 
-        // Handle identifiers and reserved words
-        else if (isalpha(currentChar))
-        {
-            currentLexeme = "";
-
-            while (i < n && isalpha(sourceCode[i]))
-            {
-                currentLexeme += sourceCode[i];
-                i++;
-            }
-
-            // Check if it's a reserved keyword
-            if (reservedKeywords.count(currentLexeme))
-            {
-                tokens.push_back({reservedKeywords[currentLexeme], currentLexeme});
-            }
-            else
-            {
-                tokens.push_back({TokenType::ID, currentLexeme});
-            }
-
-            // Check for immediate digits after an ID
-            if (i < n && isdigit(sourceCode[i]))
-            {
-                // This is generally an error in TINY, but based on your original logic:
-                string numLexeme = "";
-                while (i < n && isdigit(sourceCode[i]))
-                {
-                    numLexeme += sourceCode[i];
-                    i++;
-                }
-                if (!numLexeme.empty())
-                {
-                    tokens.push_back({TokenType::NUMBER, numLexeme});
-                }
-            }
-            continue;
-        }
+string Lexer::errorMessage(const Token &errorToken) const
+{
+    const ScanDiagnostic *diagnostic = findDiagnostic(errors, errorToken.offset);
+    return diagnostic ? diagnostic->message : TokenSource::errorMessage(errorToken);
+}
 
-        // Handle special symbols and operators
-        else if (currentChar == ':')
-        {
-            if (i + 1 < n && sourceCode[i + 1] == '=')
-            {
-                tokens.push_back({TokenType::ASSIGN, ":="});
-                i += 2;
-            }
-            else
-            {
-                scannerErrorMessage = "Scanner Error: Expected ':=' but found ':' at position " + to_string(i) + ".";
-                tokens.clear();
-                return tokens;
-            }
-        }
-        else if (currentChar == ';')
-        {
-            tokens.push_back({TokenType::SEMICOLON, ";"});
-            i++;
-        }
-        else if (currentChar == '<')
-        {
-            tokens.push_back({TokenType::LESSTHAN, "<"});
-            i++;
-        }
-        else if (currentChar == '=')
-        {
-            tokens.push_back({TokenType::EQUAL, "="});
-            i++;
-        }
-        else if (currentChar == '+')
-        {
-            tokens.push_back({TokenType::PLUS, "+"});
-            i++;
-        }
-        else if (currentChar == '-')
-        {
-            tokens.push_back({TokenType::MINUS, "-"});
-            i++;
-        }
-        else if (currentChar == '*')
-        {
-            tokens.push_back({TokenType::MULT, "*"});
-            i++;
-        }
-        else if (currentChar == '/')
-        {
-            tokens.push_back({TokenType::DIV, "/"});
-            i++;
-        }
-        else if (currentChar == '(')
-        {
-            tokens.push_back({TokenType::OPENBRACKET, "("});
-            i++;
-        }
-        else if (currentChar == ')')
-        {
-            tokens.push_back({TokenType::CLOSEDBRACKET, ")"});
-            i++;
-        }
-        else if (currentChar == '{') // Handle TINY comment start
-        {
-            // Skip the '{'
-            i++;
-            int startPos = i - 1;
-            // Consume characters until '}' is found
-            while (i < n && sourceCode[i] != '}')
-            {
-                i++;
-            }
-            // Check if we reached end of file without closing the comment
-            if (i >= n)
-            {
-                scannerErrorMessage = "Scanner Error: Unclosed comment starting at position " + to_string(startPos) + ".";
-                tokens.clear();
-                return tokens;
-            }
-            // Skip the closing '}'
-            i++;
-            continue;
-        }
+const ScanDiagnostic *findDiagnostic(const vector<ScanDiagnostic> &diagnostics, uint32_t offset)
+{
+    auto found = lower_bound(diagnostics.begin(), diagnostics.end(), offset,
+                             [](const ScanDiagnostic &d, uint32_t offset) { return d.offset < offset; });
+    return found != diagnostics.end() && found->offset == offset ? &*found : nullptr;
+}
 
-        // Numbers
-        else if (isdigit(currentChar))
-        {
-            currentLexeme = "";
+// Runs the DFA from the current position up to the end of the next token
+Token Lexer::next()
+{
+    const char *data = source.data();
+    size_t n = source.length();
+    size_t i = pos;
+    size_t tokenStart = i;
+    uint8_t state = S_START;
+    const ScanKernels &kernels = scanKernels();
 
-            while (i < n && isdigit(sourceCode[i]))
-            {
-                currentLexeme += sourceCode[i];
-                i++;
-            }
+    while (i < n)
+    {
+        char currentChar = data[i];
+        uint8_t step = dfa[state][charClass(currentChar)];
 
-            tokens.push_back({TokenType::NUMBER, currentLexeme});
+        if (step < S_COUNT)
+        {
+            // Still inside a lexeme (or whitespace); remember where it began
+            if (state == S_START)
+                tokenStart = i;
+            state = step;
+            i = skipRun(kernels, state, data, i + 1, n);
+            continue;
         }
 
-        else
+        string_view lexeme = source.substr(tokenStart, i - tokenStart);
+        switch (step)
         {
-            scannerErrorMessage = "Scanner Error: Unexpected character '" + string(1, currentChar) + "' at position " + to_string(i) + ".";
-            tokens.clear();
-            return tokens;
+        case A_EMIT_WORD:
+            pos = i;
+            return word(tokenStart, lexeme.length());
+        case A_EMIT_NUMBER:
+            pos = i;
+            return number(tokenStart, lexeme.length());
+        case A_EMIT_ASSIGN:
+            pos = i + 1;
+            return make(TokenType::ASSIGN, tokenStart, 2);
+        case A_EMIT_SYMBOL:
+            pos = i + 1;
+            return make(symbolTokens[static_cast<unsigned char>(currentChar)], i, 1);
+        case A_ERROR_COLON:
+            // Carry on with whatever follows the lone ':'
+            return fail(LexError::BadAssign, tokenStart, 1, tokenStart + 1);
+        default: // A_ERROR_CHAR
+            return fail(LexError::UnexpectedChar, i, 1, i + 1);
         }
     }
 
-    // Only add ENDFILE if no error occurred
-    if (tokens.empty() && scannerErrorMessage.empty())
+    // Close whatever lexeme was open when the input ran out
+    pos = n;
+    string_view lexeme = source.substr(tokenStart, n - tokenStart);
+    switch (state)
     {
-        // Handle case where code is empty (or only whitespace)
-        tokens.push_back({TokenType::ENDFILE, "EOF"});
+    case S_ID:
+        return word(tokenStart, lexeme.length());
+    case S_NUMBER:
+        return number(tokenStart, lexeme.length());
+    case S_COLON:
+        return fail(LexError::BadAssign, tokenStart, lexeme.length(), n);
+    case S_COMMENT:
+        return fail(LexError::UnclosedComment, tokenStart, lexeme.length(), n);
+    default:
+        return makeToken(TokenType::ENDFILE, static_cast<uint32_t>(n), "EOF");
     }
-    else if (!tokens.empty())
+}
+
+// The scanner function: errors become ERROR tokens plus a diagnostic each,
+// and scanning carries on, so one pass reports every lexical error.
+// Lexemes are views into sourceCode, so no per-token string is allocated.
+namespace
+{
+// Fills an empty (but possibly pre-sized) result
+void scanInto(string_view sourceCode, ScanResult &result)
+{
+    Lexer lexer(sourceCode, *result.symbols);
+
+    for (;;)
     {
-        tokens.push_back({TokenType::ENDFILE, "EOF"});
+        Token token = lexer.next();
+        result.tokens.push_back(token);
+        if (token.type == TokenType::ENDFILE)
+            break;
     }
+    result.diagnostics = lexer.takeDiagnostics();
+    result.lines.assign(sourceCode);
+    locateDiagnostics(result.lines, result.diagnostics);
+}
+} // namespace
 
-    return tokens;
+ScanResult scan(string_view sourceCode)
+{
+    ScanResult result;
+    scanInto(sourceCode, result);
+    return result;
+}
+
+// =======================
+//    Reusable Scanner
+// =======================
+
+void Scanner::reset(string_view source)
+{
+    this->source = source;
+}
+
+const ScanResult &Scanner::scan()
+{
+    // clear() keeps every buffer's capacity for this run
+    current.tokens.clear();
+    current.diagnostics.clear();
+    if (current.symbols.use_count() == 1)
+        current.symbols->clear();
+    else
+        current.symbols = make_shared<Interner>(); // a tree still names its identifiers by it
+    scanInto(source, current);
+    return current;
 }
+
+void locateDiagnostics(const LineIndex &lines, vector<ScanDiagnostic> &diagnostics)
+{
+    for (ScanDiagnostic &diagnostic : diagnostics)
+    {
+        SourceLocation location = lines.locate(diagnostic.offset);
+        diagnostic.line = location.line;
+        diagnostic.column = location.column;
+    }
+}
+
 // Main function with command line argument handling
 // int main(int argc, char *argv[])
 // {
@@ -319,13 +464,15 @@ vector<Token>scan(const string &sourceCode)
 
 //         // Scan the source code
 //         cout << "Scanning source code..." << endl;
-//         vector<Token> tokens = scan(sourceCode);
+//         ScanResult result = scan(sourceCode);
+//         vector<Token> &tokens = result.tokens;
 
 //         // Check for scanning errors
-//         if (tokens.empty() && !scannerErrorMessage.empty())
+//         if (!result.ok())
 //         {
 //             cerr << "\n--- Scanning failed ---" << endl;
-//             cerr << scannerErrorMessage << endl;
+//             for (const auto &diagnostic : result.diagnostics)
+//                 cerr << diagnostic.line << ":" << diagnostic.column << ": " << diagnostic.message << endl;
 //             return 1;
 //         }
 
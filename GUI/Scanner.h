@@ -1,9 +1,15 @@
 #ifndef SCANNER_H
 #define SCANNER_H
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
+#include "Interner.h"
+#include "LineIndex.h"
 
 // =======================
 //      Token Types
@@ -34,26 +40,176 @@ enum class TokenType
     NUMBER
 };
 
+// Names of the token types, indexed by TokenType
+inline constexpr std::string_view TokenTypeNames[] = {
+    "IF", "THEN", "ELSE", "END", "REPEAT", "UNTIL", "READ", "WRITE",
+    "SEMICOLON", "ASSIGN", "ID", "ENDFILE", "ERROR", "LESSTHAN", "EQUAL",
+    "PLUS", "MINUS", "MULT", "DIV", "OPENBRACKET", "CLOSEDBRACKET", "NUMBER"};
+static_assert(std::size(TokenTypeNames) == static_cast<size_t>(TokenType::NUMBER) + 1,
+              "TokenTypeNames must list every TokenType");
+
+constexpr std::string_view tokenTypeName(TokenType type)
+{
+    size_t index = static_cast<size_t>(type);
+    return index < std::size(TokenTypeNames) ? TokenTypeNames[index] : "UNKNOWN";
+}
+
 // =======================
 //      Token Struct
 // =======================
+//
+// A token does not own its text: `lexeme` is a view into the source buffer
+// that was handed to scan(). Lifetime rule: that buffer must stay alive and
+// unmodified for as long as any token (or copy of one) produced from it is
+// in use. Fixed lexemes such as "EOF" refer to string literals instead.
+//
+// `offset` is the byte position of the token in the source (the source
+// length for ENDFILE). It stays meaningful after the buffer is edited or
+// freed; sources are limited to 4 GiB so it fits in 32 bits.
+//
+// The last field depends on the type, which says which member is live:
+//   ID      `symbol`, the name's SymbolId when scanned with an Interner
+//           (NoSymbol otherwise)
+//   NUMBER  `value`, the literal decoded at scan time
+// Other tokens leave it at NoSymbol.
 struct Token
 {
     TokenType type;
-    std::string lexeme;
+    uint32_t offset;
+    std::string_view lexeme;
+    union
+    {
+        SymbolId symbol = NoSymbol;
+        int64_t value;
+    };
+
+    // Source bytes covered by the token (empty for ENDFILE)
+    SourceSpan span() const
+    {
+        return {offset, offset + (type == TokenType::ENDFILE ? 0 : static_cast<uint32_t>(lexeme.length()))};
+    }
 };
 
+// A token with `symbol` at NoSymbol; the caller sets `value` for a NUMBER.
+// Brace-initialising a Token would leave the union to its default member
+// initializer, which -Wextra reports at every such site.
+inline Token makeToken(TokenType type, uint32_t offset, std::string_view lexeme)
+{
+    Token token;
+    token.type = type;
+    token.offset = offset;
+    token.lexeme = lexeme;
+    return token;
+}
+
 // =======================
-//  Reserved Keywords Map
+//   Scanner Diagnostics
 // =======================
 
-extern std::map<std::string, TokenType> reservedKeywords;
+enum class LexError
+{
+    None,
+    BadAssign,       // ':' not followed by '='
+    UnexpectedChar,  // byte that cannot start a token
+    UnclosedComment, // '{' with no matching '}'
+    NumberOverflow   // literal above INT64_MAX
+};
+
+// One lexical error. Every diagnostic has a matching ERROR token at the same
+// offset. `line` and `column` are 1-based (the column counts bytes) and are 0
+// until locateDiagnostics() has filled them in.
+struct ScanDiagnostic
+{
+    LexError kind;
+    uint32_t offset;
+    uint32_t line;
+    uint32_t column;
+    std::string message;
+};
+
+// The message scan() gives for an error of `kind` at `offset`
+std::string lexErrorMessage(LexError kind, std::string_view source, size_t offset);
+
+// The diagnostic at `offset` in a list sorted by offset, or nullptr
+const ScanDiagnostic *findDiagnostic(const std::vector<ScanDiagnostic> &diagnostics, uint32_t offset);
+
+// Fills in line and column from the line index of the scanned text
+void locateDiagnostics(const LineIndex &lines, std::vector<ScanDiagnostic> &diagnostics);
 
 // =======================
-//    Global Error String
+//      Token Sources
 // =======================
+//
+// Anything the parser can pull tokens from one at a time. After ENDFILE
+// next() keeps returning ENDFILE.
+class TokenSource
+{
+public:
+    virtual ~TokenSource() = default;
+    virtual Token next() = 0;
+
+    // Message describing an ERROR token returned by next()
+    virtual std::string errorMessage(const Token &errorToken) const
+    {
+        return "Scanner Error: Invalid token '" + std::string(errorToken.lexeme) + "' at position " +
+               std::to_string(errorToken.offset) + ".";
+    }
+};
+
+// Produces tokens from `source` on demand, so scanning can run fused with
+// parsing. A lexical error is returned as an ERROR token (whose lexeme is
+// the offending text), recorded in diagnostics(), and scanning carries on
+// right after it; an unclosed comment swallows the rest of the input. The
+// lifetime rule on Token applies to `source`.
+class Lexer : public TokenSource
+{
+public:
+    // Starts scanning at byte `start` of `source`, which must be a token
+    // boundary outside any comment. Positions in messages are relative to
+    // the start of `source`. Throws std::length_error past 4 GiB.
+    explicit Lexer(std::string_view source, size_t start = 0);
+    Lexer(std::string &&source, size_t start = 0) = delete;
+
+    // Same, and interns every identifier into `symbols`, which must
+    // outlive the lexer
+    Lexer(std::string_view source, Interner &symbols, size_t start = 0);
+    Lexer(std::string &&source, Interner &symbols, size_t start = 0) = delete;
+
+    Token next() override;
+    std::string errorMessage(const Token &errorToken) const override;
 
-extern std::string scannerErrorMessage;
+    // Errors met so far, in source order, with line and column not yet set
+    const std::vector<ScanDiagnostic> &diagnostics() const { return errors; }
+    std::vector<ScanDiagnostic> takeDiagnostics() { return std::move(errors); }
+
+private:
+    Token make(TokenType type, size_t start, size_t length) const;
+    Token word(size_t start, size_t length) const;
+    Token number(size_t start, size_t length);
+    Token fail(LexError kind, size_t offset, size_t length, size_t resume);
+
+    std::string_view source;
+    size_t pos = 0;
+    Interner *symbols = nullptr;
+    std::vector<ScanDiagnostic> errors;
+};
+
+// =======================
+//      Scan Results
+// =======================
+
+struct ScanResult
+{
+    std::vector<Token> tokens;               // always ends with ENDFILE
+    std::vector<ScanDiagnostic> diagnostics; // located, in source order
+    LineIndex lines;                         // of the scanned text
+
+    // Names of the ID tokens. Shared, so a tree parsed from the result can
+    // name its identifiers by the same IDs and outlive the result.
+    std::shared_ptr<Interner> symbols = std::make_shared<Interner>();
+
+    bool ok() const { return diagnostics.empty(); }
+};
 
 // =======================
 //   Utility Declarations
@@ -61,14 +217,61 @@ extern std::string scannerErrorMessage;
 
 std::string tokenTypeToString(TokenType type);
 
+// Copies a whole file into a string. On Windows CRLF line endings become
+// LF, as a text-mode stream reads them; elsewhere the bytes are kept as
+// they are. To scan large files without the copy, scan
+// SourceBuffer::fromFile(filename).view() instead; its offsets count the
+// raw bytes, '\r' included, on every platform.
 std::string readFile(const std::string &filename);
 
+// Writes the tokens as text, one "Lexeme: ..., Type: ..." line each.
+// Throws std::runtime_error if the file cannot be written.
 void writeFile(const std::string &filename, const std::vector<Token> &tokens);
 
 // =======================
 //     Scanner Function
 // =======================
 
-std::vector<Token>scan(const std::string &sourceCode);
+// Scans the whole input in one pass, collecting every lexical error rather
+// than stopping at the first. Tokens point into `sourceCode` (see the
+// lifetime rule on Token). Safe to call from several threads at once.
+ScanResult scan(std::string_view sourceCode);
+
+// Scanning a temporary would leave every token dangling.
+ScanResult scan(std::string &&sourceCode) = delete;
+
+// Same result as scan() (tokens and diagnostics), but large inputs are
+// split into chunks that are lexed on `threads` worker threads
+// (0 = one per hardware thread).
+ScanResult scanParallel(std::string_view sourceCode, unsigned threads = 0);
+ScanResult scanParallel(std::string &&sourceCode, unsigned threads = 0) = delete;
+
+// =======================
+//    Reusable Scanner
+// =======================
+//
+// Scans one text after another into the same ScanResult, keeping its token
+// vector, line index and symbol table (with the name storage) between runs.
+// Once warmed up, scanning a text of about the same size and vocabulary
+// allocates nothing, unless it has lexical errors: their messages are
+// strings, or a tree parsed from the last result still shares its symbol
+// table: the next scan() then starts a new one. Each scan() overwrites the
+// previous result.
+class Scanner
+{
+public:
+    // Makes `source` the text the next scan() reads. Tokens point into it,
+    // so it must outlive the result.
+    void reset(std::string_view source);
+    void reset(std::string &&source) = delete;
+
+    // Same result as ::scan(source)
+    const ScanResult &scan();
+    const ScanResult &result() const { return current; }
+
+private:
+    std::string_view source;
+    ScanResult current;
+};
 
 #endif // SCANNER_H
@@ -0,0 +1,232 @@
+#include "ScannerSimd.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCANNER_X86 1
+#endif
+
+namespace
+{
+
+// =======================
+//      Run Predicates
+// =======================
+//
+// Each run type answers "does this byte continue the run?" for one byte
+// (test) and for 16/32 bytes at once (sse2/avx2, 0xFF lanes = continue).
+
+struct SpaceRun
+{
+    static bool test(unsigned char c)
+    {
+        return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+    }
+#ifdef SCANNER_X86
+#ifdef __SSE2__
+    static __m128i sse2(__m128i x)
+    {
+        __m128i lim = _mm_set1_epi8('\r' - '\t');
+        __m128i ctrl = _mm_sub_epi8(x, _mm_set1_epi8('\t'));
+        __m128i isCtrl = _mm_cmpeq_epi8(_mm_min_epu8(ctrl, lim), ctrl);
+        return _mm_or_si128(isCtrl, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+    }
+#endif
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i x)
+    {
+        __m256i lim = _mm256_set1_epi8('\r' - '\t');
+        __m256i ctrl = _mm256_sub_epi8(x, _mm256_set1_epi8('\t'));
+        __m256i isCtrl = _mm256_cmpeq_epi8(_mm256_min_epu8(ctrl, lim), ctrl);
+        return _mm256_or_si256(isCtrl, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+    }
+#endif
+};
+
+struct AlphaRun
+{
+    static bool test(unsigned char c)
+    {
+        return static_cast<unsigned char>((c | 0x20) - 'a') <= 'z' - 'a';
+    }
+#ifdef SCANNER_X86
+#ifdef __SSE2__
+    static __m128i sse2(__m128i x)
+    {
+        __m128i lim = _mm_set1_epi8('z' - 'a');
+        __m128i lower = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        return _mm_cmpeq_epi8(_mm_min_epu8(lower, lim), lower);
+    }
+#endif
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i x)
+    {
+        __m256i lim = _mm256_set1_epi8('z' - 'a');
+        __m256i lower = _mm256_sub_epi8(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(lower, lim), lower);
+    }
+#endif
+};
+
+struct DigitRun
+{
+    static bool test(unsigned char c)
+    {
+        return static_cast<unsigned char>(c - '0') <= 9;
+    }
+#ifdef SCANNER_X86
+#ifdef __SSE2__
+    static __m128i sse2(__m128i x)
+    {
+        __m128i lim = _mm_set1_epi8(9);
+        __m128i value = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+        return _mm_cmpeq_epi8(_mm_min_epu8(value, lim), value);
+    }
+#endif
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i x)
+    {
+        __m256i lim = _mm256_set1_epi8(9);
+        __m256i value = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(value, lim), value);
+    }
+#endif
+};
+
+struct CommentRun
+{
+    static bool test(unsigned char c)
+    {
+        return c != '}';
+    }
+#ifdef SCANNER_X86
+#ifdef __SSE2__
+    static __m128i sse2(__m128i x)
+    {
+        return _mm_xor_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('}')), _mm_set1_epi8(-1));
+    }
+#endif
+    __attribute__((target("avx2"))) static __m256i avx2(__m256i x)
+    {
+        return _mm256_xor_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('}')), _mm256_set1_epi8(-1));
+    }
+#endif
+};
+
+// =======================
+//        Kernels
+// =======================
+
+template <typename Run>
+size_t skipScalar(const char *data, size_t i, size_t n)
+{
+    while (i < n && Run::test(static_cast<unsigned char>(data[i])))
+        i++;
+    return i;
+}
+
+#if defined(SCANNER_X86) && defined(__SSE2__)
+template <typename Run>
+size_t skipSse2(const char *data, size_t i, size_t n)
+{
+    // Most runs are short; don't pay for a vector load on those
+    if (i < n && !Run::test(static_cast<unsigned char>(data[i])))
+        return i;
+
+    while (i + 16 <= n)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(Run::sse2(x))) & 0xFFFFu;
+        if (stop)
+            return i + __builtin_ctz(stop);
+        i += 16;
+    }
+    return skipScalar<Run>(data, i, n);
+}
+#endif
+
+#ifdef SCANNER_X86
+template <typename Run>
+__attribute__((target("avx2"))) size_t skipAvx2(const char *data, size_t i, size_t n)
+{
+    if (i < n && !Run::test(static_cast<unsigned char>(data[i])))
+        return i;
+
+    while (i + 32 <= n)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(Run::avx2(x)));
+        if (stop)
+            return i + __builtin_ctz(stop);
+        i += 32;
+    }
+    return skipScalar<Run>(data, i, n);
+}
+#endif
+
+// =======================
+//   Line Start Kernels
+// =======================
+//
+// Newlines are rare, so these look for them a whole vector at a time and
+// only visit the set bits of the match mask.
+
+void lineStartsScalar(const char *data, size_t i, size_t n, std::vector<uint32_t> &starts)
+{
+    while (const void *newline = i < n ? memchr(data + i, '\n', n - i) : nullptr)
+    {
+        i = static_cast<const char *>(newline) - data + 1;
+        starts.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+#if defined(SCANNER_X86) && defined(__SSE2__)
+void lineStartsSse2(const char *data, size_t i, size_t n, std::vector<uint32_t> &starts)
+{
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, newline)));
+        for (; mask; mask &= mask - 1)
+            starts.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask) + 1));
+    }
+    lineStartsScalar(data, i, n, starts);
+}
+#endif
+
+#ifdef SCANNER_X86
+__attribute__((target("avx2"))) void lineStartsAvx2(const char *data, size_t i, size_t n, std::vector<uint32_t> &starts)
+{
+    const __m256i newline = _mm256_set1_epi8('\n');
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, newline)));
+        for (; mask; mask &= mask - 1)
+            starts.push_back(static_cast<uint32_t>(i + __builtin_ctz(mask) + 1));
+    }
+    lineStartsScalar(data, i, n, starts);
+}
+#endif
+
+ScanKernels pickKernels()
+{
+#ifdef SCANNER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return {skipAvx2<SpaceRun>, skipAvx2<AlphaRun>, skipAvx2<DigitRun>, skipAvx2<CommentRun>, lineStartsAvx2, "avx2"};
+    }
+#endif
+#if defined(SCANNER_X86) && defined(__SSE2__)
+    return {skipSse2<SpaceRun>, skipSse2<AlphaRun>, skipSse2<DigitRun>, skipSse2<CommentRun>, lineStartsSse2, "sse2"};
+#else
+    return {skipScalar<SpaceRun>, skipScalar<AlphaRun>, skipScalar<DigitRun>, skipScalar<CommentRun>, lineStartsScalar, "scalar"};
+#endif
+}
+
+} // namespace
+
+const ScanKernels &scanKernels()
+{
+    static const ScanKernels kernels = pickKernels();
+    return kernels;
+}
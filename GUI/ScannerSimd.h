@@ -0,0 +1,35 @@
+#ifndef SCANNER_SIMD_H
+#define SCANNER_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =======================
+//   Scanner Run Kernels
+// =======================
+//
+// Each kernel starts at index `i` of `data[0..n)` and returns the index of
+// the first byte that does NOT belong to the run (or n). They use AVX2 or
+// SSE2 when the CPU has it and fall back to plain loops otherwise; the
+// implementation is picked once, on first use.
+
+struct ScanKernels
+{
+    // Whitespace as defined by isspace() in the C locale
+    size_t (*skipSpace)(const char *data, size_t i, size_t n);
+    // Letters a-z / A-Z
+    size_t (*skipAlpha)(const char *data, size_t i, size_t n);
+    // Digits 0-9
+    size_t (*skipDigits)(const char *data, size_t i, size_t n);
+    // Everything up to (not including) the next '}'
+    size_t (*skipComment)(const char *data, size_t i, size_t n);
+    // Appends j + 1 to `starts` for every '\n' at index j in [i, n)
+    void (*lineStarts)(const char *data, size_t i, size_t n, std::vector<uint32_t> &starts);
+    // "avx2", "sse2" or "scalar"
+    const char *name;
+};
+
+const ScanKernels &scanKernels();
+
+#endif // SCANNER_SIMD_H
@@ -0,0 +1,308 @@
+#include "SourceBuffer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace std;
+
+namespace
+{
+// Bytes requested per read() when streaming
+constexpr size_t ChunkSize = 1 << 16;
+
+// Reads everything `readSome` produces into `out`, a malloc() block that
+// grows by doubling, reading straight into it. realloc() can move a large
+// block by remapping its pages rather than copying them, so the input is
+// not held twice while it grows, as it would be in a std::string.
+// readSome(dst, capacity) returns the byte count, 0 at end of input and
+// a negative value on error.
+template <typename ReadSome>
+bool readChunks(char *&out, size_t &used, ReadSome readSome)
+{
+    size_t capacity = 0;
+    used = 0;
+    for (;;)
+    {
+        if (capacity - used < ChunkSize)
+        {
+            capacity = max(2 * capacity, used + ChunkSize);
+            char *grown = static_cast<char *>(realloc(out, capacity));
+            if (!grown)
+                throw bad_alloc();
+            out = grown;
+        }
+
+        long got = readSome(out + used, capacity - used);
+        if (got < 0)
+            return false;
+        if (got == 0)
+            break;
+        used += static_cast<size_t>(got);
+    }
+    return true;
+}
+} // namespace
+
+SourceBuffer::~SourceBuffer()
+{
+    release();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+SourceBuffer &SourceBuffer::operator=(SourceBuffer &&other) noexcept
+{
+    if (this == &other)
+        return *this;
+
+    release();
+    size_ = other.size_;
+    mapping_ = other.mapping_;
+    mappingHandle_ = other.mappingHandle_;
+    streamed_ = other.streamed_;
+    data_ = other.data_;
+
+    other.data_ = "";
+    other.size_ = 0;
+    other.mapping_ = nullptr;
+    other.mappingHandle_ = nullptr;
+    other.streamed_ = nullptr;
+    return *this;
+}
+
+void SourceBuffer::release()
+{
+    if (mapping_)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mapping_);
+        CloseHandle(static_cast<HANDLE>(mappingHandle_));
+#else
+        munmap(mapping_, size_);
+#endif
+    }
+    data_ = "";
+    size_ = 0;
+    mapping_ = nullptr;
+    mappingHandle_ = nullptr;
+    free(streamed_);
+    streamed_ = nullptr;
+}
+
+#ifdef _WIN32
+
+static bool readHandle(HANDLE handle, char *&out, size_t &used)
+{
+    return readChunks(out, used, [handle](char *dst, size_t capacity) -> long {
+        DWORD got = 0;
+        if (!ReadFile(handle, dst, static_cast<DWORD>(capacity), &got, nullptr))
+            return GetLastError() == ERROR_BROKEN_PIPE ? 0 : -1;
+        return static_cast<long>(got);
+    });
+}
+
+struct Mapping
+{
+    void *view; // null if the file could not be mapped
+    size_t size;
+    HANDLE handle;
+};
+
+// A read-only view of the disk file open as `file`, from its start
+static Mapping mapHandle(HANDLE file)
+{
+    LARGE_INTEGER fileSize;
+    if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &fileSize) &&
+        fileSize.QuadPart > 0 && static_cast<unsigned long long>(fileSize.QuadPart) <= SIZE_MAX)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view)
+                return {view, static_cast<size_t>(fileSize.QuadPart), mapping};
+            CloseHandle(mapping);
+        }
+    }
+    return {nullptr, 0, nullptr};
+}
+
+SourceBuffer SourceBuffer::fromFile(const string &filename)
+{
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw runtime_error("Error: Cannot open input file '" + filename + "'");
+    }
+
+    SourceBuffer buffer;
+    Mapping mapped = mapHandle(file);
+    if (mapped.view)
+    {
+        CloseHandle(file);
+        buffer.mapping_ = mapped.view;
+        buffer.mappingHandle_ = mapped.handle;
+        buffer.data_ = static_cast<const char *>(mapped.view);
+        buffer.size_ = mapped.size;
+        return buffer;
+    }
+
+    bool ok = readHandle(file, buffer.streamed_, buffer.size_);
+    CloseHandle(file);
+    if (!ok)
+    {
+        throw runtime_error("Error: Cannot read input file '" + filename + "'");
+    }
+    if (buffer.streamed_)
+        buffer.data_ = buffer.streamed_;
+    return buffer;
+}
+
+SourceBuffer SourceBuffer::fromStdin()
+{
+    // Input redirected from a file is mapped like one, unless some of it
+    // has been read already
+    SourceBuffer buffer;
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    LARGE_INTEGER zero = {};
+    LARGE_INTEGER position;
+    if (SetFilePointerEx(input, zero, &position, FILE_CURRENT) && position.QuadPart == 0)
+    {
+        Mapping mapped = mapHandle(input);
+        if (mapped.view)
+        {
+            buffer.mapping_ = mapped.view;
+            buffer.mappingHandle_ = mapped.handle;
+            buffer.data_ = static_cast<const char *>(mapped.view);
+            buffer.size_ = mapped.size;
+            return buffer;
+        }
+    }
+
+    if (!readHandle(input, buffer.streamed_, buffer.size_))
+    {
+        throw runtime_error("Error: Cannot read standard input");
+    }
+    if (buffer.streamed_)
+        buffer.data_ = buffer.streamed_;
+    return buffer;
+}
+
+#else
+
+static bool readDescriptor(int fd, char *&out, size_t &used)
+{
+    return readChunks(out, used, [fd](char *dst, size_t capacity) -> long {
+        ssize_t got;
+        do
+        {
+            got = ::read(fd, dst, capacity);
+        } while (got < 0 && errno == EINTR);
+        return static_cast<long>(got);
+    });
+}
+
+struct Mapping
+{
+    void *view; // null if the file could not be mapped
+    size_t size;
+};
+
+// A read-only view of the regular file open as `fd`, from its start
+static Mapping mapDescriptor(int fd)
+{
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+        static_cast<unsigned long long>(info.st_size) <= SIZE_MAX)
+    {
+        size_t size = static_cast<size_t>(info.st_size);
+        void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED)
+        {
+            madvise(view, size, MADV_SEQUENTIAL);
+            return {view, size};
+        }
+    }
+    return {nullptr, 0};
+}
+
+SourceBuffer SourceBuffer::fromFile(const string &filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("Error: Cannot open input file '" + filename + "'");
+    }
+
+    SourceBuffer buffer;
+    Mapping mapped = mapDescriptor(fd);
+    if (mapped.view)
+    {
+        ::close(fd);
+        buffer.mapping_ = mapped.view;
+        buffer.data_ = static_cast<const char *>(mapped.view);
+        buffer.size_ = mapped.size;
+        return buffer;
+    }
+
+    bool ok = readDescriptor(fd, buffer.streamed_, buffer.size_);
+    ::close(fd);
+    if (!ok)
+    {
+        throw runtime_error("Error: Cannot read input file '" + filename + "'");
+    }
+    if (buffer.streamed_)
+        buffer.data_ = buffer.streamed_;
+    return buffer;
+}
+
+SourceBuffer SourceBuffer::fromStdin()
+{
+    // Input redirected from a file is mapped like one, unless some of it
+    // has been read already
+    SourceBuffer buffer;
+    if (lseek(STDIN_FILENO, 0, SEEK_CUR) == 0)
+    {
+        Mapping mapped = mapDescriptor(STDIN_FILENO);
+        if (mapped.view)
+        {
+            buffer.mapping_ = mapped.view;
+            buffer.data_ = static_cast<const char *>(mapped.view);
+            buffer.size_ = mapped.size;
+            return buffer;
+        }
+    }
+
+    if (!readDescriptor(STDIN_FILENO, buffer.streamed_, buffer.size_))
+    {
+        throw runtime_error("Error: Cannot read standard input");
+    }
+    if (buffer.streamed_)
+        buffer.data_ = buffer.streamed_;
+    return buffer;
+}
+
+#endif
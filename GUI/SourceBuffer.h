@@ -0,0 +1,64 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// =======================
+//      Source Buffer
+// =======================
+//
+// Read-only program text for the scanner. Regular files, and stdin when it
+// is redirected from one, are memory-mapped, so the text is never copied.
+// Pipes and character devices are read in fixed-size chunks straight into
+// one contiguous buffer. Either way the scanner sees a single contiguous
+// view, so identifiers, numbers, ':=' and comments that straddle a read
+// boundary need no special handling.
+//
+// A pipe is still held whole, not scanned a chunk at a time: tokens point
+// into the text, so none of it can be dropped while they live. The buffer
+// grows without a second copy of the input, so the peak memory is about the
+// input's size; bench/SourceBench measures it against the old readFile().
+//
+// The text is the file's raw bytes: CRLF line endings are kept (the scanner
+// skips '\r' as whitespace), so token offsets and columns are byte offsets
+// into the file as stored, which for CRLF files are not offsets into the
+// editor's text. On Windows, readFile() gives a copy with LF line endings.
+//
+// Tokens produced from view() point into this object; keep it alive (and
+// do not move it) while they are in use.
+class SourceBuffer
+{
+public:
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    SourceBuffer(SourceBuffer &&other) noexcept;
+    SourceBuffer &operator=(SourceBuffer &&other) noexcept;
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    // Maps `filename`, or streams it when it cannot be mapped.
+    // Throws std::runtime_error if the file cannot be opened or read.
+    static SourceBuffer fromFile(const std::string &filename);
+
+    // Maps standard input if it is a regular file not yet read from, and
+    // otherwise streams it until end of file.
+    static SourceBuffer fromStdin();
+
+    std::string_view view() const { return {data_, size_}; }
+    std::size_t size() const { return size_; }
+    bool isMapped() const { return mapping_ != nullptr; }
+
+private:
+    void release();
+
+    const char *data_ = "";
+    std::size_t size_ = 0;
+    void *mapping_ = nullptr;      // start of the mapped view, if mapped
+    void *mappingHandle_ = nullptr; // Windows file-mapping object
+    char *streamed_ = nullptr;     // contents when not mapped, from malloc()
+};
+
+#endif // SOURCE_BUFFER_H
@@ -0,0 +1,19 @@
+#include "SyntaxTree.h"
+#include <algorithm>
+#include <cstdint>
+
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    uintptr_t at = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (!cursor || at + size > reinterpret_cast<uintptr_t>(limit)) {
+        // Objects larger than a block get a block of their own
+        size_t length = std::max(BlockSize, size + alignment);
+        blocks.push_back(std::make_unique<char[]>(length));
+        blockBytes += length;
+        cursor = blocks.back().get();
+        limit = cursor + length;
+        at = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+    cursor = reinterpret_cast<char*>(at + size);
+    return reinterpret_cast<void*>(at);
+}
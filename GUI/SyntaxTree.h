@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ASTNode.h"
+
+// =======================
+//        AST Arena
+// =======================
+//
+// Bump allocator: objects are carved out of 64 KiB blocks one after the
+// other, so making one costs a pointer bump, and the whole arena is freed
+// block by block when it is destroyed. Nothing is destroyed individually,
+// so only trivially destructible objects may live here.
+class Arena {
+public:
+    Arena() = default;
+    Arena(Arena&& other) noexcept { *this = std::move(other); }
+    Arena& operator=(Arena&& other) noexcept {
+        // The moved-from arena must not keep bumping into blocks it gave away
+        blocks = std::move(other.blocks);
+        cursor = std::exchange(other.cursor, nullptr);
+        limit = std::exchange(other.limit, nullptr);
+        blockBytes = std::exchange(other.blockBytes, 0);
+        return *this;
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t size, size_t alignment);
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Bytes held in blocks
+    size_t memoryUsage() const { return blockBytes; }
+
+private:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t blockBytes = 0;
+};
+
+// =======================
+//       Syntax Tree
+// =======================
+//
+// A parsed program: the root node and the arena holding every node and
+// node text. Dropping the tree frees all of it.
+class SyntaxTree {
+public:
+    SyntaxTree() = default;
+
+    ASTNode* root() const { return top; }
+    void setRoot(ASTNode* node) { top = node; }
+
+    Arena& arena() { return nodes; }
+    size_t memoryUsage() const { return nodes.memoryUsage(); }
+
+private:
+    Arena nodes;
+    ASTNode* top = nullptr;
+};
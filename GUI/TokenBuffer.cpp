@@ -0,0 +1,111 @@
+#include "TokenBuffer.h"
+#include <algorithm>
+
+using namespace std;
+
+void TokenBuffer::reserve(size_t count)
+{
+    types.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+}
+
+void TokenBuffer::push(const Token &token)
+{
+    uint32_t length = token.span().length();
+    if (length >= LongLength)
+        longLengths.push_back({static_cast<uint32_t>(types.size()), length});
+    if (token.type == TokenType::ID)
+        symbols.push_back(token.symbol);
+    else if (token.type == TokenType::NUMBER)
+        literals.push_back(token.value);
+
+    types.push_back(static_cast<uint8_t>(token.type));
+    offsets.push_back(token.offset);
+    lengths.push_back(static_cast<uint16_t>(min<uint32_t>(length, LongLength)));
+}
+
+uint32_t TokenBuffer::length(size_t index) const
+{
+    if (lengths[index] != LongLength)
+        return lengths[index];
+    auto found = lower_bound(longLengths.begin(), longLengths.end(), index,
+                             [](const LongLengthEntry &entry, size_t index) { return entry.index < index; });
+    return found->length;
+}
+
+size_t TokenBuffer::memoryUsage() const
+{
+    return types.capacity() * sizeof(uint8_t) + offsets.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint16_t) + symbols.capacity() * sizeof(SymbolId) +
+           literals.capacity() * sizeof(int64_t) + longLengths.capacity() * sizeof(longLengths[0]);
+}
+
+Token TokenBuffer::const_iterator::operator*() const
+{
+    TokenType type = static_cast<TokenType>(buffer->types[index]);
+    uint32_t offset = buffer->offsets[index];
+    if (type == TokenType::ENDFILE)
+        return makeToken(type, offset, "EOF");
+
+    uint32_t length = buffer->lengths[index];
+    if (length == LongLength)
+        length = buffer->longLengths[longIndex].length;
+    // push() only takes tokens of this source, so no bounds check is needed
+    Token token = makeToken(type, offset, string_view(buffer->text.data() + offset, length));
+    if (type == TokenType::ID)
+        token.symbol = buffer->symbols[symbolIndex];
+    else if (type == TokenType::NUMBER)
+        token.value = buffer->literals[literalIndex];
+    return token;
+}
+
+TokenBuffer::const_iterator &TokenBuffer::const_iterator::operator++()
+{
+    symbolIndex += buffer->types[index] == static_cast<uint8_t>(TokenType::ID);
+    literalIndex += buffer->types[index] == static_cast<uint8_t>(TokenType::NUMBER);
+    longIndex += buffer->lengths[index] == LongLength;
+    index++;
+    return *this;
+}
+
+TokenBuffer scanToBuffer(string_view sourceCode, Interner &symbols)
+{
+    TokenBuffer tokens(sourceCode);
+    // Dense code averages a little over 3 bytes per token
+    tokens.reserve(sourceCode.length() / 4 + 1);
+
+    Lexer lexer(sourceCode, symbols);
+    for (;;)
+    {
+        Token token = lexer.next();
+        tokens.push(token);
+        if (token.type == TokenType::ENDFILE)
+            break;
+    }
+
+    vector<ScanDiagnostic> diagnostics = lexer.takeDiagnostics();
+    if (!diagnostics.empty())
+        locateDiagnostics(LineIndex(sourceCode), diagnostics);
+    tokens.setDiagnostics(std::move(diagnostics));
+    return tokens;
+}
+
+Token BufferTokenSource::next()
+{
+    if (cursor == tokens.end())
+    {
+        if (!tokens.empty() && tokens.type(tokens.size() - 1) == TokenType::ENDFILE)
+            return makeToken(TokenType::ENDFILE, tokens.offset(tokens.size() - 1), "EOF");
+        return makeToken(TokenType::ENDFILE, static_cast<uint32_t>(tokens.source().length()), "EOF");
+    }
+    Token token = *cursor;
+    ++cursor;
+    return token;
+}
+
+string BufferTokenSource::errorMessage(const Token &errorToken) const
+{
+    const ScanDiagnostic *diagnostic = findDiagnostic(tokens.diagnostics(), errorToken.offset);
+    return diagnostic ? diagnostic->message : TokenSource::errorMessage(errorToken);
+}
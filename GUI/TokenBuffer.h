@@ -0,0 +1,141 @@
+#ifndef TOKEN_BUFFER_H
+#define TOKEN_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Scanner.h"
+
+// =======================
+//      Token Buffer
+// =======================
+//
+// Scanned tokens stored column by column instead of as an array of Token:
+// a byte for the type, a 32-bit source offset and a 16-bit length, so a
+// token takes 7 bytes instead of sizeof(Token). The rarer parts live in
+// side tables that are read in step with the tokens:
+//   - the symbol of every ID token, in token order
+//   - the decoded value of every NUMBER token (the literal pool)
+//   - lengths of 64 KiB or more (the length column then holds LongLength)
+//
+// Tokens are rebuilt on the fly by const_iterator, or pulled one at a time
+// through BufferTokenSource, e.g. by the parser. The lifetime rule on Token
+// applies to the source the buffer was filled from.
+class TokenBuffer
+{
+public:
+    TokenBuffer() = default;
+    explicit TokenBuffer(std::string_view source) : text(source) {}
+
+    void reserve(size_t count);
+
+    // Appends a token scanned from source()
+    void push(const Token &token);
+
+    size_t size() const { return types.size(); }
+    bool empty() const { return types.empty(); }
+    std::string_view source() const { return text; }
+
+    TokenType type(size_t index) const { return static_cast<TokenType>(types[index]); }
+    uint32_t offset(size_t index) const { return offsets[index]; }
+    uint32_t length(size_t index) const;
+
+    // Errors behind the ERROR tokens, in source order
+    const std::vector<ScanDiagnostic> &diagnostics() const { return errors; }
+    void setDiagnostics(std::vector<ScanDiagnostic> diagnostics) { errors = std::move(diagnostics); }
+
+    // Bytes held by the columns and side tables
+    size_t memoryUsage() const;
+
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Token;
+
+        const_iterator() = default;
+
+        Token operator*() const;
+        const_iterator &operator++();
+        const_iterator operator++(int)
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+    private:
+        friend class TokenBuffer;
+        const_iterator(const TokenBuffer *buffer, size_t index) : buffer(buffer), index(index) {}
+
+        const TokenBuffer *buffer = nullptr;
+        size_t index = 0;
+        size_t symbolIndex = 0;  // next entry of buffer->symbols
+        size_t literalIndex = 0; // next entry of buffer->literals
+        size_t longIndex = 0;   // next entry of buffer->longLengths
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+
+private:
+    // The .tok file format stores the columns as they are (see TokenFile.h)
+    friend class TokenFile;
+    friend void writeTokenFile(const std::string &filename, const TokenBuffer &tokens, const Interner &symbols);
+
+    static constexpr uint16_t LongLength = UINT16_MAX;
+
+    // The length of a token whose length column holds LongLength. A plain
+    // struct, so the .tok file can copy the column as raw bytes.
+    struct LongLengthEntry
+    {
+        uint32_t index;
+        uint32_t length;
+    };
+
+    std::string_view text;
+    std::vector<uint8_t> types;
+    std::vector<uint32_t> offsets;
+    std::vector<uint16_t> lengths;
+    std::vector<SymbolId> symbols;                          // one per ID token
+    std::vector<int64_t> literals;                          // one per NUMBER token
+    std::vector<LongLengthEntry> longLengths;               // by token index
+    std::vector<ScanDiagnostic> errors;
+};
+
+// Scans `sourceCode` straight into a TokenBuffer (ending with ENDFILE),
+// interning identifiers into `symbols`. Diagnostics are located.
+TokenBuffer scanToBuffer(std::string_view sourceCode, Interner &symbols);
+TokenBuffer scanToBuffer(std::string &&sourceCode, Interner &symbols) = delete;
+
+// =======================
+//   Buffer Token Source
+// =======================
+//
+// Feeds a TokenBuffer to the parser front to back. Past the end it keeps
+// returning ENDFILE.
+class BufferTokenSource : public TokenSource
+{
+public:
+    explicit BufferTokenSource(const TokenBuffer &tokens)
+        : tokens(tokens), cursor(tokens.begin()) {}
+
+    Token next() override;
+    std::string errorMessage(const Token &errorToken) const override;
+
+private:
+    const TokenBuffer &tokens;
+    TokenBuffer::const_iterator cursor;
+};
+
+#endif // TOKEN_BUFFER_H
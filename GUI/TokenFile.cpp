@@ -0,0 +1,234 @@
+#include "TokenFile.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+constexpr char Magic[8] = {'T', 'I', 'N', 'Y', 'T', 'O', 'K', '\0'};
+constexpr uint32_t ByteOrderMark = 0x01020304;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t sourceLength;
+    uint64_t tokenCount;
+    uint64_t symbolCount;  // ID tokens
+    uint64_t literalCount; // NUMBER tokens
+    uint64_t longCount;
+    uint64_t nameBytes;
+    uint32_t nameCount;
+    uint32_t diagnosticCount;
+};
+
+struct StoredDiagnostic
+{
+    uint32_t kind;
+    uint32_t offset;
+    uint32_t line;
+    uint32_t column;
+};
+
+size_t padding(size_t bytes)
+{
+    return (8 - bytes % 8) % 8;
+}
+
+void writePadding(ofstream &out, size_t bytes)
+{
+    static const char zeros[8] = {};
+    out.write(zeros, padding(bytes));
+}
+
+void writeSection(ofstream &out, const void *data, size_t bytes)
+{
+    out.write(static_cast<const char *>(data), bytes);
+    writePadding(out, bytes);
+}
+
+// Walks the mapped file section by section, checking every bound
+class SectionReader
+{
+public:
+    SectionReader(string_view file, const string &filename) : file(file), filename(filename) {}
+
+    const char *take(uint64_t bytes)
+    {
+        if (bytes > file.length() - pos || padding(bytes) > file.length() - pos - bytes)
+            fail("is truncated");
+        const char *data = file.data() + pos;
+        pos += bytes + padding(bytes);
+        return data;
+    }
+
+    template <typename T>
+    void takeInto(vector<T> &out, uint64_t count)
+    {
+        static_assert(is_trivially_copyable_v<T>, "columns are copied as raw bytes");
+        if (count > (file.length() - pos) / sizeof(T))
+            fail("is truncated");
+        out.resize(count);
+        const char *data = take(count * sizeof(T));
+        if (count > 0)
+            memcpy(out.data(), data, count * sizeof(T));
+    }
+
+    [[noreturn]] void fail(const string &problem) const
+    {
+        throw runtime_error("Error: Token file '" + filename + "' " + problem);
+    }
+
+private:
+    string_view file;
+    const string &filename;
+    size_t pos = 0;
+};
+} // namespace
+
+void writeTokenFile(const string &filename, const TokenBuffer &tokens, const Interner &symbols)
+{
+    ofstream out(filename, ios::binary);
+    if (!out.is_open())
+    {
+        throw runtime_error("Error: Cannot open output file '" + filename + "'");
+    }
+
+    vector<uint32_t> nameLengths(symbols.size());
+    uint64_t nameBytes = 0;
+    for (SymbolId id = 0; id < symbols.size(); id++)
+    {
+        nameLengths[id] = static_cast<uint32_t>(symbols.name(id).length());
+        nameBytes += nameLengths[id];
+    }
+
+    vector<StoredDiagnostic> diagnostics;
+    diagnostics.reserve(tokens.errors.size());
+    for (const ScanDiagnostic &diagnostic : tokens.errors)
+        diagnostics.push_back({static_cast<uint32_t>(diagnostic.kind), diagnostic.offset, diagnostic.line, diagnostic.column});
+
+    Header header = {};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = TokenFileVersion;
+    header.byteOrder = ByteOrderMark;
+    header.sourceLength = tokens.text.length();
+    header.tokenCount = tokens.types.size();
+    header.symbolCount = tokens.symbols.size();
+    header.literalCount = tokens.literals.size();
+    header.longCount = tokens.longLengths.size();
+    header.nameBytes = nameBytes;
+    header.nameCount = static_cast<uint32_t>(symbols.size());
+    header.diagnosticCount = static_cast<uint32_t>(diagnostics.size());
+
+    writeSection(out, &header, sizeof(header));
+    writeSection(out, tokens.text.data(), tokens.text.length());
+    writeSection(out, tokens.types.data(), tokens.types.size() * sizeof(uint8_t));
+    writeSection(out, tokens.offsets.data(), tokens.offsets.size() * sizeof(uint32_t));
+    writeSection(out, tokens.lengths.data(), tokens.lengths.size() * sizeof(uint16_t));
+    writeSection(out, tokens.symbols.data(), tokens.symbols.size() * sizeof(SymbolId));
+    writeSection(out, tokens.literals.data(), tokens.literals.size() * sizeof(int64_t));
+    writeSection(out, tokens.longLengths.data(), tokens.longLengths.size() * sizeof(tokens.longLengths[0]));
+    writeSection(out, nameLengths.data(), nameLengths.size() * sizeof(uint32_t));
+    for (SymbolId id = 0; id < symbols.size(); id++)
+        out.write(symbols.name(id).data(), symbols.name(id).length());
+    writePadding(out, nameBytes);
+    writeSection(out, diagnostics.data(), diagnostics.size() * sizeof(StoredDiagnostic));
+
+    out.flush();
+    if (!out)
+    {
+        throw runtime_error("Error: Cannot write output file '" + filename + "'");
+    }
+}
+
+TokenFile::TokenFile(const string &filename)
+    : file(SourceBuffer::fromFile(filename))
+{
+    SectionReader reader(file.view(), filename);
+    if (file.size() < sizeof(Header))
+        reader.fail("is not a token file");
+    Header header;
+    memcpy(&header, reader.take(sizeof(Header)), sizeof(Header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0)
+        reader.fail("is not a token file");
+    if (header.byteOrder != ByteOrderMark)
+        reader.fail("was written on a machine of another byte order");
+    if (header.version != TokenFileVersion)
+        reader.fail("has version " + to_string(header.version) + ", expected " + to_string(TokenFileVersion));
+    if (header.sourceLength > UINT32_MAX)
+        reader.fail("is inconsistent");
+
+    buffer.text = string_view(reader.take(header.sourceLength), header.sourceLength);
+    reader.takeInto(buffer.types, header.tokenCount);
+    reader.takeInto(buffer.offsets, header.tokenCount);
+    reader.takeInto(buffer.lengths, header.tokenCount);
+    reader.takeInto(buffer.symbols, header.symbolCount);
+    reader.takeInto(buffer.literals, header.literalCount);
+    reader.takeInto(buffer.longLengths, header.longCount);
+
+    vector<uint32_t> nameLengths;
+    reader.takeInto(nameLengths, header.nameCount);
+    const char *name = reader.take(header.nameBytes);
+    uint64_t nameEnd = 0;
+    for (uint32_t length : nameLengths)
+    {
+        nameEnd += length;
+        if (length == 0 || nameEnd > header.nameBytes)
+            reader.fail("has a bad symbol table");
+        size_t expected = names.size();
+        if (names.intern(string_view(name, length)) != expected)
+            reader.fail("has a bad symbol table"); // a name listed twice
+        name += length;
+    }
+
+    vector<StoredDiagnostic> diagnostics;
+    reader.takeInto(diagnostics, header.diagnosticCount);
+
+    // The token iterator trusts the side tables to be in step with the
+    // columns and every lexeme to lie inside the source, so check that once
+    size_t ids = 0, numbers = 0, longs = 0;
+    for (size_t k = 0; k < buffer.types.size(); k++)
+    {
+        if (buffer.types[k] > static_cast<uint8_t>(TokenType::NUMBER))
+            reader.fail("has a bad token type");
+        uint64_t length = buffer.lengths[k];
+        if (length == TokenBuffer::LongLength)
+        {
+            if (longs == buffer.longLengths.size() || buffer.longLengths[longs].index != k)
+                reader.fail("has a bad long-token table");
+            length = buffer.longLengths[longs++].length;
+        }
+        if (static_cast<TokenType>(buffer.types[k]) != TokenType::ENDFILE &&
+            buffer.offsets[k] + length > header.sourceLength)
+            reader.fail("has a token outside the source");
+        if (static_cast<TokenType>(buffer.types[k]) == TokenType::ID)
+        {
+            if (ids == buffer.symbols.size() ||
+                (buffer.symbols[ids] != NoSymbol && buffer.symbols[ids] >= names.size()))
+                reader.fail("has a bad symbol");
+            ids++;
+        }
+        numbers += static_cast<TokenType>(buffer.types[k]) == TokenType::NUMBER;
+    }
+    if (ids != buffer.symbols.size() || numbers != buffer.literals.size() || longs != buffer.longLengths.size())
+        reader.fail("is inconsistent");
+
+    // Messages are worded afresh from the embedded source
+    buffer.errors.reserve(diagnostics.size());
+    for (const StoredDiagnostic &stored : diagnostics)
+    {
+        if (stored.kind > static_cast<uint32_t>(LexError::NumberOverflow) || stored.offset > header.sourceLength)
+            reader.fail("has a bad diagnostic");
+        // These two quote the character at their offset, so it must be one
+        LexError kind = static_cast<LexError>(stored.kind);
+        if ((kind == LexError::UnexpectedChar || kind == LexError::BadAssign) && stored.offset == header.sourceLength)
+            reader.fail("has a bad diagnostic");
+        buffer.errors.push_back({kind, stored.offset, stored.line, stored.column,
+                                 lexErrorMessage(kind, buffer.text, stored.offset)});
+    }
+}
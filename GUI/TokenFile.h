@@ -0,0 +1,61 @@
+#ifndef TOKEN_FILE_H
+#define TOKEN_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "Interner.h"
+#include "SourceBuffer.h"
+#include "TokenBuffer.h"
+
+// =======================
+//     Token Files (.tok)
+// =======================
+//
+// A scanned program saved to disk, so scanning and parsing can run as
+// separate processes, or a scan can be cached. The file holds the source
+// text itself, the TokenBuffer columns and side tables exactly as they are
+// laid out in memory, the symbol names and the diagnostics:
+//
+//   header      magic "TINYTOK\0", format version, byte-order mark, counts
+//   source      sourceLength bytes
+//   types       uint8_t per token
+//   offsets     uint32_t per token
+//   lengths     uint16_t per token
+//   symbols     uint32_t per ID token
+//   literals    int64_t per NUMBER token
+//   long        (uint32_t index, uint32_t length) per token of 64 KiB or more
+//   names       uint32_t length per symbol, then the names back to back
+//   diagnostics (kind, offset, line, column) as uint32_t each
+//
+// Every section starts on an 8-byte boundary. Numbers are in the byte
+// order of the machine that wrote the file; a file from a machine of the
+// other byte order is rejected rather than converted.
+constexpr uint32_t TokenFileVersion = 1;
+
+// Writes `tokens` (scanned from tokens.source(), with IDs from `symbols`).
+// Throws std::runtime_error if the file cannot be written.
+void writeTokenFile(const std::string &filename, const TokenBuffer &tokens, const Interner &symbols);
+
+// A token file mapped into memory. The source text is not copied: tokens()
+// and every Token it yields point into the mapping, so they are valid as
+// long as this object lives. The columns are copied out of the mapping in
+// one block each.
+class TokenFile
+{
+public:
+    // Throws std::runtime_error if the file cannot be read, is not a token
+    // file, has another version or byte order, or is inconsistent.
+    explicit TokenFile(const std::string &filename);
+
+    std::string_view source() const { return buffer.source(); }
+    const TokenBuffer &tokens() const { return buffer; }
+    const Interner &symbols() const { return names; }
+
+private:
+    SourceBuffer file;
+    TokenBuffer buffer;
+    Interner names;
+};
+
+#endif // TOKEN_FILE_H
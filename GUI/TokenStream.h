@@ -0,0 +1,143 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Scanner.h"
+
+// =======================
+//   Vector Token Source
+// =======================
+//
+// Replays an already scanned token vector. A vector that lacks a trailing
+// ENDFILE (e.g. an empty one) reads as if it had one.
+class VectorTokenSource : public TokenSource
+{
+public:
+    explicit VectorTokenSource(std::vector<Token> tokens)
+        : tokens(std::move(tokens)) {}
+
+    Token next() override
+    {
+        if (index < tokens.size())
+            return tokens[index++];
+        if (!tokens.empty() && tokens.back().type == TokenType::ENDFILE)
+            return tokens.back();
+        uint32_t end = tokens.empty() ? 0 : tokens.back().offset + static_cast<uint32_t>(tokens.back().lexeme.size());
+        return makeToken(TokenType::ENDFILE, end, "EOF");
+    }
+
+private:
+    std::vector<Token> tokens;
+    size_t index = 0;
+};
+
+// =======================
+//    Span Token Source
+// =======================
+//
+// Replays tokens that live elsewhere, e.g. in a ScanResult, without copying
+// them. The tokens must end with ENDFILE and outlive the source; past the
+// end it keeps returning that ENDFILE. Given the scanner's diagnostics,
+// errorMessage() reports the scanner's own message for an ERROR token.
+class SpanTokenSource : public TokenSource
+{
+public:
+    SpanTokenSource(const Token *tokens, size_t count, const std::vector<ScanDiagnostic> *diagnostics = nullptr)
+        : tokens(tokens), count(count), diagnostics(diagnostics) {}
+
+    Token next() override
+    {
+        const Token &token = tokens[index];
+        index = std::min(index + 1, count - 1);
+        return token;
+    }
+
+    std::string errorMessage(const Token &errorToken) const override
+    {
+        const ScanDiagnostic *diagnostic = diagnostics ? findDiagnostic(*diagnostics, errorToken.offset) : nullptr;
+        return diagnostic ? diagnostic->message : TokenSource::errorMessage(errorToken);
+    }
+
+    const Token *data() const { return tokens; }
+    size_t size() const { return count; }
+
+private:
+    const Token *tokens;
+    size_t count;
+    size_t index = 0;
+    const std::vector<ScanDiagnostic> *diagnostics;
+};
+
+// =======================
+//       Token Stream
+// =======================
+//
+// Pulls tokens from a TokenSource on demand and keeps a small ring buffer
+// of lookahead, so only Lookahead tokens are ever held at once. Over a
+// SpanTokenSource it reads the tokens in place instead: peek() and next()
+// then hand out references into the span and never call the source.
+class TokenStream
+{
+public:
+    static constexpr size_t Lookahead = 4; // power of two
+
+    explicit TokenStream(TokenSource &source)
+        : source(source)
+    {
+        if (auto *span = dynamic_cast<SpanTokenSource *>(&source))
+        {
+            tokens = span->data();
+            last = span->size() - 1;
+        }
+    }
+
+    // k-th token ahead of the current one (0 = current), k < Lookahead.
+    // The reference stays valid until the stream is advanced.
+    const Token &peek(size_t k = 0)
+    {
+        if (tokens)
+            return tokens[std::min(index + k, last)];
+        while (count <= k)
+        {
+            ring[(head + count) & (Lookahead - 1)] = source.next();
+            count++;
+        }
+        return ring[(head + k) & (Lookahead - 1)];
+    }
+
+    // Consumes and returns the current token. The reference stays valid
+    // until the next peek().
+    const Token &next()
+    {
+        const Token &token = peek();
+        if (tokens)
+        {
+            index = std::min(index + 1, last);
+            return token;
+        }
+        head = (head + 1) & (Lookahead - 1);
+        count--;
+        return token;
+    }
+
+    TokenSource &origin() { return source; }
+
+private:
+    TokenSource &source;
+
+    // In-place mode, over a SpanTokenSource
+    const Token *tokens = nullptr;
+    size_t index = 0;
+    size_t last = 0; // the ENDFILE
+
+    // Ring mode, over any other source
+    Token ring[Lookahead];
+    size_t head = 0;
+    size_t count = 0;
+};
+
+#endif // TOKEN_STREAM_H
@@ -0,0 +1,73 @@
+// The flat, index-linked AST against the ASTNode tree it replaced: the
+// memory each takes, the time to build it, and the time for a walk over
+// every node. The ASTNode tree is built by toSyntaxTree() from a parse, so
+// its build time also counts building the flat tree, and is an upper bound
+// on what the parser spent building ASTNodes directly.
+
+#include "Bench.h"
+#include "Parser.h"
+#include "SyntaxTree.h"
+
+namespace {
+
+// Adds up the span lengths, visiting every node once
+uint64_t walk(const FlatAst& ast) {
+    uint64_t total = 0;
+    std::vector<NodeId> pending{ast.root()};
+    while (!pending.empty()) {
+        const FlatNode& node = ast[pending.back()];
+        pending.pop_back();
+        total += node.span.end - node.span.begin;
+        for (NodeId child = node.firstChild; child != NoNode; child = ast[child].nextSibling)
+            pending.push_back(child);
+    }
+    return total;
+}
+
+uint64_t walk(const ASTNode* root) {
+    uint64_t total = 0;
+    std::vector<const ASTNode*> pending{root};
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        total += node->span.end - node->span.begin;
+        for (const ASTNode* child : node->children)
+            pending.push_back(child);
+    }
+    return total;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string text = benchProgram(inputBytes(argc, argv, 16));
+    const ScanResult scanned = scan(text);
+
+    FlatAst ast;
+    double parse = bestTime([&] { ast = Parser(scanned).parse(); });
+    SyntaxTree tree;
+    double convert = bestTime([&] { tree = toSyntaxTree(ast, text); });
+
+    uint64_t flatTotal = 0;
+    uint64_t treeTotal = 0;
+    double flatWalk = bestTime([&] { flatTotal = walk(ast); });
+    double treeWalk = bestTime([&] { treeTotal = walk(tree.root()); });
+
+    std::printf("ast: %.1f MB, %zu nodes\n", text.size() / 1e6, ast.size());
+    std::printf("  %-44s %9.1f MB %9.1f bytes/node\n", "ASTNode tree (before)", tree.memoryUsage() / 1e6,
+                double(tree.memoryUsage()) / ast.size());
+    std::printf("  %-44s %9.1f MB %9.1f bytes/node\n", "FlatAst", ast.memoryUsage() / 1e6,
+                double(ast.memoryUsage()) / ast.size());
+    std::printf("building:\n");
+    report("parse, then toSyntaxTree() (before)", parse + convert, text.size());
+    report("parse into FlatAst", parse, text.size());
+    std::printf("a walk over every node:\n");
+    report("ASTNode tree (before)", treeWalk, text.size());
+    report("FlatAst", flatWalk, text.size());
+
+    if (flatTotal != treeTotal) {
+        std::fprintf(stderr, "the trees have different spans\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Loading a saved .ast file against getting the tree by parsing again:
+// scanning and parsing the source (before), parsing tokens already
+// scanned, writeAstFile(), and AstFile. The tree read back must be the
+// parsed one node for node, with the same names, literals and diagnostics,
+// and must know the source it was parsed from.
+
+#include "AstFile.h"
+#include "Bench.h"
+#include <cstdio>
+
+namespace {
+
+const std::string AstFileName = "AstFileBench.ast";
+
+bool sameTree(const FlatAst& a, const FlatAst& b) {
+    if (a.size() != b.size() || a.root() != b.root())
+        return false;
+    for (NodeId id = 0; id < a.size(); id++) {
+        const FlatNode& p = a[id];
+        const FlatNode& q = b[id];
+        if (p.kind != q.kind || p.op != q.op || p.firstChild != q.firstChild || p.nextSibling != q.nextSibling ||
+            p.span.begin != q.span.begin || p.span.end != q.span.end)
+            return false;
+        bool named = p.kind == NodeKind::Assign || p.kind == NodeKind::Read || p.kind == NodeKind::Id;
+        if ((named && a.name(id) != b.name(id)) || (p.kind == NodeKind::Const && a.literal(id) != b.literal(id)))
+            return false;
+    }
+    return true;
+}
+
+bool sameDiagnostics(const std::vector<ParseDiagnostic>& a, const std::vector<ParseDiagnostic>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t k = 0; k < a.size(); k++)
+        if (a[k].offset != b[k].offset || a[k].message != b[k].message)
+            return false;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string text = benchProgram(inputBytes(argc, argv, 16));
+    const ScanResult scanned = scan(text);
+
+    ParseResult parsed;
+    double scanParse = bestTime([&] {
+        ScanResult rescanned = scan(text);
+        Parser parser(rescanned);
+        parsed.ast = parser.parse();
+    });
+    double parse = bestTime([&] {
+        Parser parser(scanned);
+        parsed.ast = parser.parse();
+        parsed.diagnostics = parser.diagnostics();
+    });
+    double write = bestTime([&] { writeAstFile(AstFileName, parsed.ast, parsed.diagnostics, text); });
+    double load = bestTime([&] { AstFile loaded(AstFileName); });
+
+    AstFile loaded(AstFileName);
+    bool same = sameTree(parsed.ast, loaded.ast()) && sameDiagnostics(parsed.diagnostics, loaded.diagnostics()) &&
+                loaded.isFor(text);
+
+    std::FILE* file = std::fopen(AstFileName.c_str(), "rb");
+    long fileSize = 0;
+    if (file && std::fseek(file, 0, SEEK_END) == 0)
+        fileSize = std::ftell(file);
+    if (file)
+        std::fclose(file);
+    std::remove(AstFileName.c_str());
+
+    std::printf("ast file: %.1f MB, %zu nodes; .ast %.1f MB\n", text.size() / 1e6, parsed.ast.size(),
+                fileSize / 1e6);
+    report("scan() and Parser (before)", scanParse, text.size());
+    report("Parser, tokens already scanned", parse, text.size());
+    report("writeAstFile()", write, text.size());
+    report("AstFile", load, text.size());
+
+    if (!same) {
+        std::fprintf(stderr, "the .ast file read back another tree\n");
+        return 1;
+    }
+    return 0;
+}
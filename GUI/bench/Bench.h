@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "Keywords.h"
+
+// =======================
+//    Benchmark Helpers
+// =======================
+//
+// Each benchmark generates its input, runs the path a request replaced and
+// the path that replaced it on the same input, and prints one line per
+// path. Times are the best of several runs, so a cold first run or a busy
+// moment on the machine does not count.
+
+constexpr int BenchRuns = 5;
+
+// Input size in MB: argv[1] if given, otherwise `fallback`
+inline size_t inputBytes(int argc, char** argv, size_t fallback) {
+    size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+    return (megabytes > 0 ? megabytes : fallback) << 20;
+}
+
+// Seconds taken by the fastest of BenchRuns calls of `work`
+template <typename Work>
+double bestTime(Work work) {
+    double best = 1e300;
+    for (int run = 0; run < BenchRuns; run++) {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        std::chrono::duration<double> taken = std::chrono::steady_clock::now() - start;
+        best = std::min(best, taken.count());
+    }
+    return best;
+}
+
+// One result line: the path, its time, and its throughput over `bytes`
+inline void report(const char* path, double seconds, size_t bytes) {
+    std::printf("  %-44s %9.2f ms %9.1f MB/s\n", path, seconds * 1e3, bytes / seconds / 1e6);
+}
+
+// A TINY program of about `bytes` bytes: assignments, reads and writes,
+// if and repeat blocks, and comments, over a thousand names of 1 to 8
+// letters. The same seed gives the same program.
+inline std::string benchProgram(size_t bytes, unsigned seed = 1) {
+    std::mt19937 random(seed);
+    std::vector<std::string> names;
+    while (names.size() < 1000) {
+        std::string name;
+        for (size_t length = 1 + random() % 8; length > 0; length--)
+            name += static_cast<char>('a' + random() % 26);
+        if (keywordType(name) == TokenType::ID)
+            names.push_back(name);
+    }
+    auto name = [&] { return names[random() % names.size()]; };
+    auto number = [&] { return std::to_string(random() % 100000); };
+
+    std::string text;
+    text.reserve(bytes + 256);
+    while (text.size() < bytes) {
+        if (!text.empty())
+            text += ";\n";
+        switch (random() % 6) {
+            case 0:
+                text += "read " + name();
+                break;
+            case 1:
+                text += name() + " := " + name() + " + " + number() + " * (" + name() + " - " + name() + ")";
+                break;
+            case 2:
+                text += "write " + name() + " / " + number();
+                break;
+            case 3:
+                text += "if " + name() + " < " + number() + " then\n  " + name() + " := " + name() +
+                        " - 1\nelse\n  write " + name() + "\nend";
+                break;
+            case 4:
+                text += "repeat\n  " + name() + " := " + name() + " * 2;\n  write " + name() + "\nuntil " +
+                        name() + " = " + number();
+                break;
+            default:
+                text += "{ " + name() + " holds the running total }\n" + name() + " := 0";
+                break;
+        }
+    }
+    return text;
+}
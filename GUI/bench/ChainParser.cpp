@@ -0,0 +1,396 @@
+#include "ChainParser.h"
+#include <stdexcept>
+#include <iostream>
+
+
+namespace {
+
+bool endsWithEndfile(const std::vector<Token>& tokens) {
+    return !tokens.empty() && tokens.back().type == TokenType::ENDFILE;
+}
+
+std::vector<Token> withEndfile(std::vector<Token> tokens) {
+    if (!endsWithEndfile(tokens)) {
+        uint32_t end = tokens.empty() ? 0 : tokens.back().span().end;
+        tokens.push_back(makeToken(TokenType::ENDFILE, end, "EOF"));
+    }
+    return tokens;
+}
+
+// Serves `tokens` in place when they end with ENDFILE
+std::unique_ptr<TokenSource> sourceFor(const std::vector<Token>& tokens,
+                                       const std::vector<ScanDiagnostic>* diagnostics = nullptr) {
+    if (endsWithEndfile(tokens))
+        return std::make_unique<SpanTokenSource>(tokens.data(), tokens.size(), diagnostics);
+    return std::make_unique<VectorTokenSource>(tokens);
+}
+
+} // namespace
+
+ChainParser::ChainParser(const std::vector<Token>& tokens)
+    : ownedSource(sourceFor(tokens)),
+      stream(*ownedSource) {
+}
+
+ChainParser::ChainParser(std::vector<Token>&& tokens)
+    : ownedTokens(withEndfile(std::move(tokens))),
+      ownedSource(sourceFor(ownedTokens)),
+      stream(*ownedSource) {
+}
+
+ChainParser::ChainParser(const ScanResult& result)
+    : ownedSource(sourceFor(result.tokens, &result.diagnostics)),
+      stream(*ownedSource) {
+}
+
+ChainParser::ChainParser(const TokenBuffer& tokens)
+    : ownedSource(std::make_unique<BufferTokenSource>(tokens)),
+      stream(*ownedSource) {
+}
+
+ChainParser::ChainParser(TokenSource& source)
+    : stream(source) {
+}
+
+
+// Runs whenever a new token becomes current, so every adjacent pair is
+// checked exactly once while parsing instead of in a separate pass.
+void ChainParser::validateCurrent() {
+    const Token& current = stream.peek(0);
+
+    // Scanner errors arrive as ERROR tokens; the first one ends the parse
+    if (current.type == TokenType::ERROR) {
+        throw std::runtime_error(stream.origin().errorMessage(current));
+    }
+
+    const Token& next = stream.peek(1);
+
+    // Check for ID followed by NUMBER (e.g., "min" then "123")
+    if (current.type == TokenType::ID && next.type == TokenType::NUMBER) {
+        throw std::runtime_error(
+            "Syntax Error: Consecutive tokens mismatch. Identifier '" +
+            std::string(current.lexeme) + "' followed by Number '" + std::string(next.lexeme) + "'"
+            );
+    }
+
+    // Check for IF followed by ELSE
+    if (current.type == TokenType::IF && next.type == TokenType::ELSE) {
+        throw std::runtime_error(
+            "Syntax Error: Forbidden sequence 'if' immediately followed by 'else'."
+            );
+    }
+}
+
+void ChainParser::advance() {
+    if (stream.peek().type == TokenType::ENDFILE)
+        return;
+    lastEnd = stream.next().span().end;
+    validateCurrent();
+}
+
+// Gives `node` the span from `begin` to the end of the last consumed token
+NodeId ChainParser::spanFrom(NodeId node, uint32_t begin) {
+    ast[node].span = {begin, lastEnd};
+    return node;
+}
+
+OpKind ChainParser::opKind(TokenType type) {
+    switch (type) {
+        case TokenType::LESSTHAN: return OpKind::Less;
+        case TokenType::EQUAL:    return OpKind::Equal;
+        case TokenType::PLUS:     return OpKind::Plus;
+        case TokenType::MINUS:    return OpKind::Minus;
+        case TokenType::MULT:     return OpKind::Times;
+        case TokenType::DIV:      return OpKind::Divide;
+        default:                  return OpKind::None;
+    }
+}
+
+
+void ChainParser::expect(TokenType type) {
+    if (currentType() != type) {
+        throw std::runtime_error(
+            "Syntax Error: expected " + tokenTypeToString(type) +
+            " but found " + tokenTypeToString(currentType())
+        );
+    }
+    advance();
+}
+
+////////////////////////////////  RULES   /////////////////////////////////////
+//
+// The grammar runs on an explicit stack of frames instead of the native
+// call stack, so nesting depth is bounded only by memory. Each rule is cut
+// into steps at its sub-rule "calls": call() pushes the sub-rule's frame,
+// and when a rule is done it leaves its node in `result`, pops its frame,
+// and the frame below resumes at the step it saved. The steps run in the
+// same order as the recursive descent they replace, so the AST and the
+// first error reported are the same.
+
+// Starts sub-rule `step` on top of the current frame. The caller's frame
+// reference is invalid afterwards.
+void ChainParser::call(Step step) {
+    frames.push_back({step, NoNode, NoNode, 0});
+}
+
+NodeId ChainParser::program() {
+    NodeId result = NoNode;
+    frames.clear();
+    call(Step::Sequence);
+
+    while (!frames.empty()) {
+        Frame& f = frames.back();
+        switch (f.step) {
+
+        // stmt-sequence → statement { ; statement }
+        case Step::Sequence:
+            f.step = Step::SequenceNext;
+            call(Step::Statement);
+            break;
+
+        case Step::SequenceNext:
+            if (f.node == NoNode)
+                f.node = result;                    // the first statement
+            else
+                ast.appendChild(f.left, result);    // chained to the previous one
+            f.left = result;
+            if (currentType() == TokenType::SEMICOLON) {
+                advance(); // consume ';'
+                call(Step::Statement);
+            } else {
+                result = f.node;
+                frames.pop_back();
+            }
+            break;
+
+        case Step::Statement:
+            switch (currentType()) {
+                case TokenType::IF:     f.step = Step::If; break;
+                case TokenType::REPEAT: f.step = Step::Repeat; break;
+                case TokenType::ID:     f.step = Step::Assign; break;
+                case TokenType::READ:   f.step = Step::Read; break;
+                case TokenType::WRITE:  f.step = Step::Write; break;
+                default:
+                    throw std::runtime_error("Syntax Error: unexpected token in statement: " +
+                                             tokenTypeToString(currentType()));
+            }
+            break;
+
+        // if-stmt → if exp then stmt-sequence [else stmt-sequence] end
+        case Step::If:
+            f.begin = currentToken().offset;
+            expect(TokenType::IF);
+            f.node = ast.add(NodeKind::If);
+            f.step = Step::IfThen;
+            call(Step::Exp);
+            break;
+
+        case Step::IfThen:
+            ast.appendChild(f.node, result);
+            expect(TokenType::THEN);
+            f.step = Step::IfElse;
+            call(Step::Sequence);
+            break;
+
+        case Step::IfElse:
+            ast.appendChild(f.node, result);
+            if (currentType() == TokenType::ELSE) {
+                advance();
+                f.step = Step::IfEnd;
+                call(Step::Sequence);
+                break;
+            }
+            expect(TokenType::END);
+            result = spanFrom(f.node, f.begin);
+            frames.pop_back();
+            break;
+
+        case Step::IfEnd:
+            ast.appendChild(f.node, result);
+            expect(TokenType::END);
+            result = spanFrom(f.node, f.begin);
+            frames.pop_back();
+            break;
+
+        // repeat-stmt → repeat stmt-sequence until exp
+        case Step::Repeat:
+            f.begin = currentToken().offset;
+            expect(TokenType::REPEAT);
+            f.node = ast.add(NodeKind::Repeat);
+            f.step = Step::RepeatUntil;
+            call(Step::Sequence);
+            break;
+
+        case Step::RepeatUntil:
+            ast.appendChild(f.node, result);
+            expect(TokenType::UNTIL);
+            f.step = Step::LastChild;
+            call(Step::Exp);
+            break;
+
+        // assign-stmt → identifier := exp
+        case Step::Assign:
+            f.begin = currentToken().offset;
+            f.node = ast.addName(NodeKind::Assign, currentToken().lexeme);
+            expect(TokenType::ID);
+            expect(TokenType::ASSIGN);
+            f.step = Step::LastChild;
+            call(Step::Exp);
+            break;
+
+        // read-stmt → read identifier
+        case Step::Read: {
+            f.begin = currentToken().offset;
+            expect(TokenType::READ);
+            Token id = currentToken();
+            expect(TokenType::ID);
+            result = spanFrom(ast.addName(NodeKind::Read, id.lexeme), f.begin);
+            frames.pop_back();
+            break;
+        }
+
+        // write-stmt → write exp
+        case Step::Write:
+            f.begin = currentToken().offset;
+            expect(TokenType::WRITE);
+            f.node = ast.add(NodeKind::Write);
+            f.step = Step::LastChild;
+            call(Step::Exp);
+            break;
+
+        // A statement's trailing exp has been parsed
+        case Step::LastChild:
+            ast.appendChild(f.node, result);
+            result = spanFrom(f.node, f.begin);
+            frames.pop_back();
+            break;
+
+        ////////////////////// EXPRESSIONS //////////////////////
+
+        // exp → simple-exp [comparison-op simple-exp]
+        case Step::Exp:
+            f.step = Step::ExpOperator;
+            call(Step::SimpleExp);
+            break;
+
+        case Step::ExpOperator: {
+            TokenType t = currentType();
+            if (t == TokenType::LESSTHAN || t == TokenType::EQUAL) {
+                f.node = ast.add(NodeKind::Op, opKind(t));
+                advance();
+                ast.appendChild(f.node, result);    // left operand
+                f.left = result;
+                f.step = Step::ExpRight;
+                call(Step::SimpleExp);
+                break;
+            }
+            frames.pop_back();                      // no comparison: the simple-exp itself
+            break;
+        }
+
+        case Step::ExpRight:
+            ast.appendChild(f.node, result);        // right operand
+            result = spanFrom(f.node, ast[f.left].span.begin);
+            frames.pop_back();
+            break;
+
+        // simple-exp → term { addop term }
+        case Step::SimpleExp:
+            f.step = Step::SimpleExpOperator;
+            call(Step::Term);
+            break;
+
+        case Step::SimpleExpOperator:
+            if (currentType() == TokenType::PLUS || currentType() == TokenType::MINUS) {
+                f.node = ast.add(NodeKind::Op, opKind(currentType()));
+                advance();
+                ast.appendChild(f.node, result);
+                f.left = result;
+                f.step = Step::SimpleExpRight;
+                call(Step::Term);
+                break;
+            }
+            frames.pop_back();
+            break;
+
+        case Step::SimpleExpRight:
+            ast.appendChild(f.node, result);
+            result = spanFrom(f.node, ast[f.left].span.begin); // result becomes the new left
+            f.step = Step::SimpleExpOperator;
+            break;
+
+        // term → factor { mulop factor }
+        case Step::Term:
+            f.step = Step::TermOperator;
+            call(Step::Factor);
+            break;
+
+        case Step::TermOperator:
+            if (currentType() == TokenType::MULT || currentType() == TokenType::DIV) {
+                f.node = ast.add(NodeKind::Op, opKind(currentType()));
+                advance();
+                ast.appendChild(f.node, result);
+                f.left = result;
+                f.step = Step::TermRight;
+                call(Step::Factor);
+                break;
+            }
+            frames.pop_back();
+            break;
+
+        case Step::TermRight:
+            ast.appendChild(f.node, result);
+            result = spanFrom(f.node, ast[f.left].span.begin);
+            f.step = Step::TermOperator;
+            break;
+
+        // factor → ( exp ) | number | identifier
+        case Step::Factor: {
+            const Token& t = currentToken();
+            uint32_t begin = t.offset;
+
+            if (t.type == TokenType::OPENBRACKET) {
+                advance();
+                f.step = Step::FactorClose;
+                call(Step::Exp);
+                break;
+            }
+
+            // `t` dies with advance(), so build the leaf first
+            if (t.type == TokenType::NUMBER) {
+                result = ast.addLiteral(t.value);
+            } else if (t.type == TokenType::ID) {
+                result = ast.addName(NodeKind::Id, t.lexeme);
+            } else {
+                throw std::runtime_error("Syntax Error: invalid factor: " +
+                                         tokenTypeToString(t.type));
+            }
+            advance();
+            spanFrom(result, begin);
+            frames.pop_back();
+            break;
+        }
+
+        case Step::FactorClose:
+            expect(TokenType::CLOSEDBRACKET);
+            frames.pop_back();                      // the parenthesized exp itself
+            break;
+        }
+    }
+
+    return result;
+}
+
+
+// ======== parse() =========
+FlatAst ChainParser::parse() {
+    validateCurrent();
+    ast.setRoot(program());
+
+    // The grammar stops at the first token it cannot use, but the
+    // consecutive-token rules cover the whole input, so keep checking
+    while (currentType() != TokenType::ENDFILE)
+        advance();
+
+    return std::move(ast);
+}
@@ -0,0 +1,78 @@
+// The parser as it was before expressions were parsed by precedence
+// climbing: Parser.h and Parser.cpp of that change's parent commit, with
+// the class renamed and its ENDFILE made by makeToken() as Token now
+// needs. Only ExprBench builds it, to time the change against.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+#include "Scanner.h"
+#include "FlatAst.h"
+#include "TokenBuffer.h"
+#include "TokenStream.h"
+
+class ChainParser {
+private:
+    std::vector<Token> ownedTokens;             // set by the moving vector constructor
+    std::unique_ptr<TokenSource> ownedSource;   // set by all but the TokenSource constructor
+    TokenStream stream;
+    uint32_t lastEnd = 0;                       // end of the last consumed token
+    FlatAst ast;                                // being built
+
+    // Valid until the next advance()
+    const Token& currentToken() { return stream.peek(0); }
+    const Token& peekNext() { return stream.peek(1); }
+    TokenType currentType() { return stream.peek(0).type; }
+
+    void advance();
+    void expect(TokenType type);
+    void validateCurrent();
+    NodeId spanFrom(NodeId node, uint32_t begin);
+    static OpKind opKind(TokenType type);
+
+    // ===== Grammar =====
+    // Where a rule resumes once its current sub-rule is done
+    enum class Step : uint8_t {
+        Sequence, SequenceNext, Statement,
+        If, IfThen, IfElse, IfEnd, Repeat, RepeatUntil, Assign, Read, Write, LastChild,
+        Exp, ExpOperator, ExpRight, SimpleExp, SimpleExpOperator, SimpleExpRight,
+        Term, TermOperator, TermRight, Factor, FactorClose
+    };
+
+    struct Frame {
+        Step step;
+        NodeId node;        // the rule's node (the first statement, for a sequence)
+        NodeId left;        // left operand, or the last statement of a sequence
+        uint32_t begin;     // where the rule's text starts
+    };
+
+    std::vector<Frame> frames;  // the parse stack, on the heap
+
+    void call(Step step);
+    NodeId program();
+
+public:
+    // Reads the tokens in place; `tokens` must outlive the parser. Tokens
+    // that do not end with ENDFILE are copied instead.
+    ChainParser(const std::vector<Token>& tokens);
+
+    // Takes over the tokens, without copying them
+    ChainParser(std::vector<Token>&& tokens);
+
+    // Reads result.tokens in place and reports scanner errors with the
+    // scanner's messages. `result` must outlive the parser.
+    ChainParser(const ScanResult& result);
+
+    // Reads the tokens straight out of `tokens`, which must outlive the parser
+    ChainParser(const TokenBuffer& tokens);
+
+    // Pulls tokens from `source` while parsing (e.g. a Lexer, so scanning
+    // and parsing run as one pass). `source` must outlive the parser.
+    ChainParser(TokenSource& source);
+
+    // Parses the whole input. Can be called once; throws std::runtime_error
+    // on the first error. toSyntaxTree() turns the result into ASTNodes.
+    FlatAst parse();
+};
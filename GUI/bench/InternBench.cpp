@@ -0,0 +1,77 @@
+// Interning every identifier of a program into dense symbol IDs, against
+// the std::string copy per identifier that came before, and against an
+// unordered_map from names to IDs. Runs once over the names of a generated
+// program (a thousand names, used over and over) and once over a list of
+// names that are nearly all distinct.
+
+#include "Bench.h"
+#include "Interner.h"
+#include "Scanner.h"
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+void compare(const char *what, const vector<string_view> &names, size_t bytes)
+{
+    size_t distinct = 0;
+    double copies = bestTime([&] {
+        vector<string> copied;
+        for (string_view name : names)
+            copied.emplace_back(name);
+        distinct = copied.size();
+    });
+    double map = bestTime([&] {
+        unordered_map<string, SymbolId> ids;
+        for (string_view name : names)
+            ids.emplace(string(name), static_cast<SymbolId>(ids.size()));
+        distinct = ids.size();
+    });
+    double interned = bestTime([&] {
+        Interner symbols;
+        for (string_view name : names)
+            symbols.intern(name);
+        distinct = symbols.size();
+    });
+
+    printf("%s: %zu names, %zu distinct\n", what, names.size(), distinct);
+    report("a std::string per name (before)", copies, bytes);
+    report("unordered_map<string, SymbolId>", map, bytes);
+    report("Interner", interned, bytes);
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const string text = benchProgram(inputBytes(argc, argv, 16));
+    ScanResult scanned = scan(text);
+    vector<string_view> programNames;
+    size_t programBytes = 0;
+    for (const Token &token : scanned.tokens)
+        if (token.type == TokenType::ID)
+        {
+            programNames.push_back(token.lexeme);
+            programBytes += token.lexeme.size();
+        }
+    compare("program identifiers", programNames, programBytes);
+
+    // 0, 1, 2, ... spelled as base-26 letters, as many bytes as the program's names
+    string spelled;
+    vector<size_t> ends;
+    for (size_t k = 0; spelled.size() < programBytes; k++)
+    {
+        size_t rest = k;
+        do
+        {
+            spelled += static_cast<char>('a' + rest % 26);
+            rest /= 26;
+        } while (rest > 0);
+        ends.push_back(spelled.size());
+    }
+    vector<string_view> distinctNames;
+    for (size_t k = 0, begin = 0; k < ends.size(); begin = ends[k++])
+        distinctNames.push_back(string_view(spelled).substr(begin, ends[k] - begin));
+    compare("distinct names", distinctNames, spelled.size());
+    return 0;
+}
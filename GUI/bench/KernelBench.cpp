@@ -0,0 +1,107 @@
+// The scanner's run kernels as picked for this CPU (AVX2 or SSE2), against
+// the byte-at-a-time loops they replaced, each on text made of its own kind
+// of run so the kernel does all the work.
+
+#include "Bench.h"
+#include "ScannerSimd.h"
+#include <cctype>
+
+using namespace std;
+
+namespace
+{
+bool isSpace(unsigned char c)
+{
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+// Runs of `body` bytes split by one `stop` byte, about `bytes` in all
+string runs(size_t bytes, size_t length, const string &body, char stop)
+{
+    string text;
+    text.reserve(bytes + length + 1);
+    while (text.size() < bytes)
+    {
+        for (size_t k = 0; k < length; k++)
+            text += body[k % body.size()];
+        text += stop;
+    }
+    return text;
+}
+
+// Steps through `text` run by run with `skip`, one byte past each stop
+template <typename Skip>
+size_t walk(const string &text, Skip skip)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < text.size(); i = skip(text.data(), i, text.size()) + 1)
+        count++;
+    return count;
+}
+
+template <typename Predicate>
+size_t skipLoop(const char *data, size_t i, size_t n, Predicate continues)
+{
+    while (i < n && continues(static_cast<unsigned char>(data[i])))
+        i++;
+    return i;
+}
+
+// Times one kernel against its loop; both must split `text` alike
+template <typename Kernel, typename Predicate>
+bool compare(const char *what, const string &text, Kernel kernel, Predicate continues)
+{
+    size_t loopRuns = 0;
+    size_t kernelRuns = 0;
+    double loop = bestTime([&] {
+        loopRuns = walk(text, [&](const char *data, size_t i, size_t n) { return skipLoop(data, i, n, continues); });
+    });
+    double simd = bestTime([&] { kernelRuns = walk(text, kernel); });
+
+    printf("%s:\n", what);
+    report("byte loop (before)", loop, text.size());
+    report((string("kernel, ") + scanKernels().name).c_str(), simd, text.size());
+    return loopRuns == kernelRuns;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const size_t bytes = inputBytes(argc, argv, 16);
+    const ScanKernels &kernels = scanKernels();
+    const string letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    bool same = true;
+
+    same &= compare("whitespace, runs of 40", runs(bytes, 40, " \t  \n", 'x'), kernels.skipSpace, isSpace);
+    same &= compare("comment bodies, runs of 200", runs(bytes, 200, "a comment; x := 1 ", '}'), kernels.skipComment,
+                    [](unsigned char c) { return c != '}'; });
+    same &= compare("identifiers, runs of 24", runs(bytes, 24, letters, ' '), kernels.skipAlpha,
+                    [](unsigned char c) { return isalpha(c) != 0; });
+    same &= compare("numbers, runs of 16", runs(bytes, 16, "0123456789", ' '), kernels.skipDigits,
+                    [](unsigned char c) { return c >= '0' && c <= '9'; });
+
+    const string lines = runs(bytes, 30, "x := y + 1;", '\n');
+    vector<uint32_t> loopStarts;
+    vector<uint32_t> kernelStarts;
+    double loop = bestTime([&] {
+        loopStarts.clear();
+        for (size_t i = 0; i < lines.size(); i++)
+            if (lines[i] == '\n')
+                loopStarts.push_back(static_cast<uint32_t>(i + 1));
+    });
+    double simd = bestTime([&] {
+        kernelStarts.clear();
+        kernels.lineStarts(lines.data(), 0, lines.size(), kernelStarts);
+    });
+    printf("line starts, lines of 31:\n");
+    report("byte loop (before)", loop, lines.size());
+    report((string("kernel, ") + kernels.name).c_str(), simd, lines.size());
+    same &= loopStarts == kernelStarts;
+
+    if (!same)
+    {
+        fprintf(stderr, "a kernel split its text differently from the loop\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+// parseParallel() at several thread counts against Parser on one thread.
+// Speedups need as many cores; on fewer the threads only take turns.
+
+#include "Bench.h"
+#include "Parser.h"
+#include <thread>
+
+int main(int argc, char** argv) {
+    const std::string text = benchProgram(inputBytes(argc, argv, 32));
+    const ScanResult scanned = scan(text);
+
+    size_t sequentialNodes = 0;
+    double sequential = bestTime([&] {
+        Parser parser(scanned);
+        sequentialNodes = parser.parse().size();
+    });
+
+    std::printf("parallel parse: %.1f MB, %zu tokens, %u hardware threads\n", text.size() / 1e6,
+                scanned.tokens.size(), std::thread::hardware_concurrency());
+    report("Parser (before)", sequential, text.size());
+
+    bool same = true;
+    for (unsigned threads : {2u, 4u, 8u}) {
+        size_t nodes = 0;
+        double parallel = bestTime([&] { nodes = parseParallel(scanned, threads).ast.size(); });
+        report(("parseParallel(), " + std::to_string(threads) + " threads").c_str(), parallel, text.size());
+        same &= nodes == sequentialNodes;
+    }
+
+    if (!same) {
+        std::fprintf(stderr, "parseParallel() built a tree of another size\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+// scanParallel() at several thread counts against scan() on one thread.
+// Speedups need as many cores; on fewer the threads only take turns.
+
+#include "Bench.h"
+#include "Scanner.h"
+#include <thread>
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    const string text = benchProgram(inputBytes(argc, argv, 32));
+    size_t sequentialTokens = 0;
+    double sequential = bestTime([&] { sequentialTokens = scan(text).tokens.size(); });
+
+    printf("parallel scan: %.1f MB, %zu tokens, %u hardware threads\n", text.size() / 1e6, sequentialTokens,
+           thread::hardware_concurrency());
+    report("scan() (before)", sequential, text.size());
+
+    bool same = true;
+    for (unsigned threads : {2u, 4u, 8u})
+    {
+        size_t tokens = 0;
+        double parallel = bestTime([&] { tokens = scanParallel(text, threads).tokens.size(); });
+        report(("scanParallel(), " + to_string(threads) + " threads").c_str(), parallel, text.size());
+        same &= tokens == sequentialTokens;
+    }
+
+    if (!same)
+    {
+        fprintf(stderr, "scanParallel() found another number of tokens\n");
+        return 1;
+    }
+    return 0;
+}
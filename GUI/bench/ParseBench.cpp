@@ -0,0 +1,35 @@
+// The parser reading scanned tokens in place, against copying them: first
+// into a vector of its own, then one Token at a time out of a
+// VectorTokenSource, as it did before. That path also names identifiers in
+// a table of the tree's own instead of sharing the scanner's.
+
+#include "Bench.h"
+#include "Parser.h"
+#include "TokenStream.h"
+
+int main(int argc, char** argv) {
+    const std::string text = benchProgram(inputBytes(argc, argv, 16));
+    const ScanResult scanned = scan(text);
+
+    size_t copiedNodes = 0;
+    size_t inPlaceNodes = 0;
+    double copied = bestTime([&] {
+        VectorTokenSource source(scanned.tokens);
+        Parser parser(source);
+        copiedNodes = parser.parse().size();
+    });
+    double inPlace = bestTime([&] {
+        Parser parser(scanned);
+        inPlaceNodes = parser.parse().size();
+    });
+
+    std::printf("parse: %.1f MB, %zu tokens, %zu nodes\n", text.size() / 1e6, scanned.tokens.size(), inPlaceNodes);
+    report("copied tokens (before)", copied, text.size());
+    report("tokens in place", inPlace, text.size());
+
+    if (copiedNodes != inPlaceNodes) {
+        std::fprintf(stderr, "the parses built trees of different sizes\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+// scan() driven by the character-class and DFA tables, against the
+// if/else chain it replaced. The chain is kept here as it was, with token
+// offsets added, and does not intern names, decode numbers or index lines
+// as scan() does, so the gap is if anything understated.
+
+#include "Bench.h"
+#include "Scanner.h"
+#include <cctype>
+#include <map>
+
+using namespace std;
+
+namespace
+{
+const map<string, TokenType, less<>> reservedKeywords = {
+    {"if", TokenType::IF},
+    {"then", TokenType::THEN},
+    {"else", TokenType::ELSE},
+    {"end", TokenType::END},
+    {"repeat", TokenType::REPEAT},
+    {"until", TokenType::UNTIL},
+    {"read", TokenType::READ},
+    {"write", TokenType::WRITE}};
+
+// The scan loop before the tables; stops at the first error
+vector<Token> branchyScan(string_view sourceCode)
+{
+    vector<Token> tokens;
+    size_t i = 0;
+    size_t n = sourceCode.length();
+    auto single = [&](TokenType type)
+    {
+        tokens.push_back(makeToken(type, static_cast<uint32_t>(i), sourceCode.substr(i, 1)));
+        i++;
+    };
+
+    while (i < n)
+    {
+        char currentChar = sourceCode[i];
+        if (isspace(currentChar))
+        {
+            i++;
+        }
+        else if (isalpha(currentChar))
+        {
+            size_t start = i;
+            while (i < n && isalpha(sourceCode[i]))
+                i++;
+            string_view lexeme = sourceCode.substr(start, i - start);
+            auto keyword = reservedKeywords.find(lexeme);
+            TokenType type = keyword != reservedKeywords.end() ? keyword->second : TokenType::ID;
+            tokens.push_back(makeToken(type, static_cast<uint32_t>(start), lexeme));
+        }
+        else if (isdigit(currentChar))
+        {
+            size_t start = i;
+            while (i < n && isdigit(sourceCode[i]))
+                i++;
+            tokens.push_back(makeToken(TokenType::NUMBER, static_cast<uint32_t>(start), sourceCode.substr(start, i - start)));
+        }
+        else if (currentChar == ':' && i + 1 < n && sourceCode[i + 1] == '=')
+        {
+            tokens.push_back(makeToken(TokenType::ASSIGN, static_cast<uint32_t>(i), sourceCode.substr(i, 2)));
+            i += 2;
+        }
+        else if (currentChar == ';')
+            single(TokenType::SEMICOLON);
+        else if (currentChar == '<')
+            single(TokenType::LESSTHAN);
+        else if (currentChar == '=')
+            single(TokenType::EQUAL);
+        else if (currentChar == '+')
+            single(TokenType::PLUS);
+        else if (currentChar == '-')
+            single(TokenType::MINUS);
+        else if (currentChar == '*')
+            single(TokenType::MULT);
+        else if (currentChar == '/')
+            single(TokenType::DIV);
+        else if (currentChar == '(')
+            single(TokenType::OPENBRACKET);
+        else if (currentChar == ')')
+            single(TokenType::CLOSEDBRACKET);
+        else if (currentChar == '{')
+        {
+            while (i < n && sourceCode[i] != '}')
+                i++;
+            if (i >= n)
+                break;
+            i++;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return tokens;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const string text = benchProgram(inputBytes(argc, argv, 16));
+    size_t oldTokens = 0;
+    size_t newTokens = 0;
+
+    double branchy = bestTime([&] { oldTokens = branchyScan(text).size(); });
+    double tables = bestTime([&] { newTokens = scan(text).tokens.size() - 1; }); // without ENDFILE
+
+    printf("scan: %.1f MB, %zu tokens\n", text.size() / 1e6, newTokens);
+    report("if/else chain (before)", branchy, text.size());
+    report("scan(), table driven", tables, text.size());
+    if (oldTokens != newTokens)
+    {
+        fprintf(stderr, "token counts differ: %zu before, %zu now\n", oldTokens, newTokens);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Peak resident memory of getting a program's text: the old readFile(),
+// which read the file through a stringstream, against SourceBuffer mapping
+// the file, mapping stdin redirected from it, and reading it from a pipe.
+// Peak RSS only grows, so each path runs in a process of its own (this
+// program again, with the path's name), which prints its peak (VmHWM, from
+// Linux's /proc). Mapped pages are the kernel's page cache, which it can
+// drop and read again, but they still count as resident while touched.
+
+#include "Bench.h"
+#include "SourceBuffer.h"
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+const char *const InputFile = "SourceBench.txt";
+
+const char *const Paths[][2] = {
+    {"empty", "nothing read (process baseline)"},
+    {"readFile", "old readFile(), via stringstream (before)"},
+    {"mapped", "SourceBuffer::fromFile(), mapped"},
+    {"stdin-file", "fromStdin(), redirected from the file"},
+    {"stdin-pipe", "fromStdin(), from a pipe"},
+};
+
+uint64_t hashText(string_view text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text)
+        hash = (hash ^ c) * 1099511628211ull;
+    return hash;
+}
+
+string oldReadFile(const string &filename)
+{
+    ifstream file(filename);
+    stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Peak resident bytes of this process so far
+size_t peakResident()
+{
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return stoull(line.substr(6)) * 1024; // in kB
+    return 0;
+}
+
+// The child: gets the text by `path`, checks it against `hash` and prints
+// its peak
+int readBy(const string &path, uint64_t hash)
+{
+    bool same = true;
+    if (path == "readFile")
+    {
+        same = hashText(oldReadFile(InputFile)) == hash;
+    }
+    else if (path != "empty")
+    {
+        SourceBuffer source = path == "mapped" ? SourceBuffer::fromFile(InputFile) : SourceBuffer::fromStdin();
+        same = hashText(source.view()) == hash;
+    }
+    printf("%zu\n", peakResident());
+    return same ? 0 : 1;
+}
+
+// Runs this program as the child for `path`; returns its peak in bytes, or
+// 0 if it failed
+size_t peakOf(const string &self, const string &path, uint64_t hash)
+{
+    string command = "'" + self + "' " + path + " " + to_string(hash);
+    if (path == "stdin-file")
+        command += string(" < ") + InputFile;
+    else if (path == "stdin-pipe")
+        command = string("cat ") + InputFile + " | " + command;
+
+    FILE *child = popen(command.c_str(), "r");
+    if (!child)
+        return 0;
+    size_t peak = 0;
+    if (fscanf(child, "%zu", &peak) != 1)
+        peak = 0;
+    return pclose(child) == 0 ? peak : 0;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc == 3 && !isdigit(static_cast<unsigned char>(argv[1][0])))
+        return readBy(argv[1], stoull(argv[2]));
+
+    string text = benchProgram(inputBytes(argc, argv, 256));
+    const uint64_t hash = hashText(text);
+    const size_t bytes = text.size();
+    ofstream(InputFile, ios::binary).write(text.data(), text.size());
+    string().swap(text);
+
+    printf("source: %.1f MB, peak RSS of each path\n", bytes / 1e6);
+    bool ok = true;
+    for (const auto &path : Paths)
+    {
+        size_t peak = peakOf(argv[0], path[0], hash);
+        printf("  %-44s %9.1f MB\n", path[1], peak / 1e6);
+        ok &= peak != 0;
+    }
+    remove(InputFile);
+
+    if (!ok)
+    {
+        fprintf(stderr, "a path failed or read other text\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+// The struct-of-arrays TokenBuffer against the vector<Token> that scan()
+// returns: the memory each takes, the time to scan into it, and the time
+// for a pass over every token.
+
+#include "Bench.h"
+#include "Scanner.h"
+#include "TokenBuffer.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    const string text = benchProgram(inputBytes(argc, argv, 16));
+
+    ScanResult scanned;
+    double vectorScan = bestTime([&] { scanned = scan(text); });
+    Interner symbols;
+    TokenBuffer buffer;
+    double bufferScan = bestTime([&] {
+        symbols.clear();
+        buffer = scanToBuffer(text, symbols);
+    });
+
+    // Count the statement separators: a pass that reads only the types
+    size_t vectorCount = 0;
+    size_t bufferCount = 0;
+    double vectorPass = bestTime([&] {
+        vectorCount = 0;
+        for (const Token &token : scanned.tokens)
+            vectorCount += token.type == TokenType::SEMICOLON;
+    });
+    double bufferPass = bestTime([&] {
+        bufferCount = 0;
+        for (size_t k = 0; k < buffer.size(); k++)
+            bufferCount += buffer.type(k) == TokenType::SEMICOLON;
+    });
+
+    const size_t tokens = scanned.tokens.size();
+    const size_t vectorBytes = scanned.tokens.capacity() * sizeof(Token);
+    printf("token buffer: %.1f MB, %zu tokens\n", text.size() / 1e6, tokens);
+    printf("  %-44s %9.1f MB %9.1f bytes/token\n", "vector<Token> (before)", vectorBytes / 1e6,
+           double(vectorBytes) / tokens);
+    printf("  %-44s %9.1f MB %9.1f bytes/token\n", "TokenBuffer", buffer.memoryUsage() / 1e6,
+           double(buffer.memoryUsage()) / buffer.size());
+    printf("scanning:\n");
+    report("scan() into vector<Token> (before)", vectorScan, text.size());
+    report("scanToBuffer()", bufferScan, text.size());
+    printf("a pass over the token types:\n");
+    report("vector<Token> (before)", vectorPass, text.size());
+    report("TokenBuffer", bufferPass, text.size());
+
+    if (buffer.size() != tokens || bufferCount != vectorCount)
+    {
+        fprintf(stderr, "the buffer holds other tokens than scan() found\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// The binary .tok file against the text token dump. Writing: the dump as
+// writeFile() used to make it (a flush and a type-name string per token),
+// the buffered writeFile(), and writeTokenFile(). Reading: nothing reads
+// the dump back, so a later process had to scan the source again, against
+// loading the .tok file. The .tok file must read back as the same tokens,
+// and the buffered dump must be the same text as the old one.
+
+#include "Bench.h"
+#include "TokenFile.h"
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+const string OldDumpFile = "TokenFileBench.old.txt";
+const string DumpFile = "TokenFileBench.txt";
+const string TokFile = "TokenFileBench.tok";
+
+// writeFile() before it was buffered
+void oldWriteFile(const string &filename, const vector<Token> &tokens)
+{
+    ofstream file(filename);
+    file << "Tokens produced by the scanner:" << endl;
+    file << "-------------------------------" << endl;
+    for (const auto &token : tokens)
+    {
+        file << "Lexeme: \"" << token.lexeme << "\"" << ", Type: " << tokenTypeToString(token.type) << endl;
+    }
+    file << "-------------------------------" << endl;
+    file << "Total tokens: " << tokens.size() << endl;
+}
+
+string contents(const string &filename)
+{
+    ifstream file(filename, ios::binary);
+    stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+bool sameTokens(const TokenBuffer &a, const Interner &aNames, const TokenBuffer &b, const Interner &bNames)
+{
+    if (a.source() != b.source() || a.size() != b.size() || aNames.size() != bNames.size() ||
+        a.diagnostics().size() != b.diagnostics().size())
+        return false;
+    for (auto x = a.begin(), y = b.begin(); x != a.end(); ++x, ++y)
+    {
+        Token p = *x;
+        Token q = *y;
+        if (p.type != q.type || p.offset != q.offset || p.lexeme != q.lexeme ||
+            (p.type == TokenType::ID && aNames.name(p.symbol) != bNames.name(q.symbol)) ||
+            (p.type == TokenType::NUMBER && p.value != q.value))
+            return false;
+    }
+    for (size_t k = 0; k < a.diagnostics().size(); k++)
+        if (a.diagnostics()[k].offset != b.diagnostics()[k].offset ||
+            a.diagnostics()[k].message != b.diagnostics()[k].message)
+            return false;
+    return true;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const string text = benchProgram(inputBytes(argc, argv, 16));
+    const ScanResult scanned = scan(text);
+    Interner symbols;
+    const TokenBuffer buffer = scanToBuffer(text, symbols);
+
+    double oldDump = bestTime([&] { oldWriteFile(OldDumpFile, scanned.tokens); });
+    double dump = bestTime([&] { writeFile(DumpFile, scanned.tokens); });
+    double write = bestTime([&] { writeTokenFile(TokFile, buffer, symbols); });
+
+    Interner rescannedSymbols;
+    double rescan = bestTime([&] {
+        rescannedSymbols.clear();
+        scanToBuffer(text, rescannedSymbols);
+    });
+    double load = bestTime([&] { TokenFile loaded(TokFile); });
+    TokenFile loaded(TokFile);
+    bool same = sameTokens(buffer, symbols, loaded.tokens(), loaded.symbols());
+
+    printf("token file: %.1f MB, %zu tokens; .tok %.1f MB, dump %.1f MB\n", text.size() / 1e6, buffer.size(),
+           contents(TokFile).size() / 1e6, contents(DumpFile).size() / 1e6);
+    printf("writing:\n");
+    report("text dump, flushed per token (before)", oldDump, text.size());
+    report("text dump, buffered", dump, text.size());
+    report("writeTokenFile()", write, text.size());
+    printf("reading back:\n");
+    report("scanning the source again (before)", rescan, text.size());
+    report("TokenFile", load, text.size());
+
+    bool sameDump = contents(DumpFile) == contents(OldDumpFile);
+    remove(OldDumpFile.c_str());
+    remove(DumpFile.c_str());
+    remove(TokFile.c_str());
+    if (!same || !sameDump)
+    {
+        fprintf(stderr, "%s\n", same ? "the buffered dump differs from the old one" : "the .tok file read back other tokens");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+# The scanner and parser sources, without the Qt front end (see GUI.pro),
+# as a library for the standalone test and benchmark builds in tests/ and
+# bench/
+
+set(CMAKE_CXX_STANDARD 17)
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+if(NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE Release)
+endif()
+
+find_package(Threads REQUIRED)
+
+add_library(tiny_core STATIC
+    ${CMAKE_CURRENT_LIST_DIR}/AstFile.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/EditorText.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/FlatAst.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/IncrementalLexer.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/IncrementalParser.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/Interner.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/LineIndex.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/ParallelParse.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/ParallelScan.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/Parser.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/Scanner.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/ScannerSimd.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/SourceBuffer.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/SyntaxTree.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/TokenBuffer.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/TokenFile.cpp)
+target_include_directories(tiny_core PUBLIC ${CMAKE_CURRENT_LIST_DIR})
+target_link_libraries(tiny_core PUBLIC Threads::Threads)
+
+# qmake's warn_on
+if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    target_compile_options(tiny_core PUBLIC -Wall -Wextra)
+endif()
@@ -1,6 +1,19 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
+#include <algorithm>
+#include <QTextCursor>
+#include <QTextDocument>
+
+namespace {
+
+// The UTF-16 units of `text`, as EditorText takes them
+std::u16string_view utf16View(const QString& text) {
+    return std::u16string_view(reinterpret_cast<const char16_t*>(text.utf16()), size_t(text.size()));
+}
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
@@ -51,6 +64,10 @@ MainWindow::MainWindow(QWidget *parent)
     )";
 
     qApp->setStyleSheet(styleSheet);
+
+    // Re-lex only what each edit touched instead of rescanning on every click
+    connect(ui->textEdit->document(), &QTextDocument::contentsChange,
+            this, &MainWindow::sourceContentsChanged);
 }
 MainWindow::~MainWindow()
 {
@@ -112,32 +129,46 @@ void MainWindow::on_frame2button_clicked()
         return;
     }
 
-    // Convert QString to std::string for the scanner
-    std::string codeStr = sourceCode.toStdString();
-
     try {
-        // Call the scanner function
-        std::vector<Token> tokens = scan(codeStr);
-
-        // Check for scanner errors
-        if (tokens.empty() && !scannerErrorMessage.empty()) {
-            // Display error in the label
-            QString errorMsg = QString::fromStdString("Scanner Error:\n" + scannerErrorMessage);
-            ui->textEdit->setText(errorMsg);
-
-            // Optional: Also show in message box
-            QMessageBox::critical(this, "Scanner Error",
-                QString::fromStdString(scannerErrorMessage));
-            return;
+        // The tokens are kept up to date as the text is edited
+        const std::vector<Token>& tokens = sourceText.parser().lexer().tokens();
+        const std::vector<ScanDiagnostic>& diagnostics = sourceText.parser().lexer().diagnostics();
+
+        // Every scanner error is reported, with the tokens around them
+        // still listed below (errors show up as ERROR tokens)
+        QString errorText;
+        for (const auto& diagnostic : diagnostics) {
+            errorText += QString("Line %1, column %2: %3\n")
+                .arg(diagnostic.line)
+                .arg(diagnostic.column)
+                .arg(QString::fromStdString(diagnostic.message));
         }
 
+        // Underline the offending text in the editor
+        QList<QTextEdit::ExtraSelection> errorMarks;
+        if (!diagnostics.empty()) {
+            for (const auto& token : tokens) {
+                if (token.type != TokenType::ERROR)
+                    continue;
+                SourceSpan span = token.span();
+                QTextEdit::ExtraSelection mark;
+                mark.cursor = QTextCursor(ui->textEdit->document());
+                mark.cursor.setPosition(documentPosition(span.begin));
+                mark.cursor.setPosition(documentPosition(span.end), QTextCursor::KeepAnchor);
+                mark.format.setUnderlineStyle(QTextCharFormat::WaveUnderline);
+                mark.format.setUnderlineColor(Qt::red);
+                errorMarks.append(mark);
+            }
+        }
+        ui->textEdit->setExtraSelections(errorMarks);
+
         // Convert tokens to QString format for display
         QString outputText;
         outputText += "Tokens produced by the scanner:\n";
         outputText += "-------------------------------\n";
 
         for (const auto& token : tokens) {
-            QString lexeme = QString::fromStdString(token.lexeme);
+            QString lexeme = QString::fromUtf8(token.lexeme.data(), token.lexeme.size());
             QString typeStr = QString::fromStdString(tokenTypeToString(token.type));
 
             // Format each token
@@ -148,9 +179,17 @@ void MainWindow::on_frame2button_clicked()
         outputText += "-------------------------------\n";
         outputText += QString("Total tokens: %1\n").arg(tokens.size());
 
+        if (!diagnostics.empty()) {
+            outputText = QString("Scanner Errors (%1):\n").arg(diagnostics.size()) + errorText + "\n" + outputText;
+        }
+
         // Display in the label
         ui->textEdit_2->setText(outputText);
 
+        if (!diagnostics.empty()) {
+            QMessageBox::critical(this, "Scanner Error", errorText.trimmed());
+        }
+
     }
     catch (const std::exception& e) {
         // Handle any exceptions
@@ -162,23 +201,63 @@ void MainWindow::on_frame2button_clicked()
 }
 
 
-void MainWindow::printASTToText(ASTNode* node, QString& output, int indentLevel) {
-    if (!node) return;
+void MainWindow::sourceContentsChanged(int position, int charsRemoved, int charsAdded)
+{
+    QTextDocument* document = ui->textEdit->document();
+    int documentLength = document->characterCount() - 1; // without the final block separator
+
+    // Fetch only the inserted text
+    QTextCursor cursor(document);
+    cursor.setPosition(std::min(position, documentLength));
+    cursor.setPosition(std::min(position + charsAdded, documentLength), QTextCursor::KeepAnchor);
+    QString inserted = cursor.selectedText();
+
+    if (size_t(position) <= sourceText.length()) {
+        sourceText.edit(position, charsRemoved, utf16View(inserted));
+        if (sourceText.length() == size_t(documentLength))
+            return;
+    }
 
-    // Create indentation
-    QString indent;
-    for (int i = 0; i < indentLevel; ++i) indent += "  | ";
+    // Out of step (the whole text was replaced): rescan the whole text
+    sourceText.setText(utf16View(ui->textEdit->toPlainText()));
+}
 
-    // Add current node details
-    output += indent + QString::fromStdString(node->type);
-    if (!node->value.empty()) {
-        output += " (" + QString::fromStdString(node->value) + ")";
-    }
-    output += "\n";
+// Position in the editor's document of byte `offset` of the parsed text
+int MainWindow::documentPosition(uint32_t offset) const
+{
+    return int(sourceText.positionOf(offset));
+}
 
-    // Recurse for children
-    for (ASTNode* child : node->children) {
-        printASTToText(child, output, indentLevel + 1);
+void MainWindow::printASTToText(ASTNode* node, QString& output, int indentLevel) {
+    // Depth first on an explicit stack, so a long program cannot overflow
+    // the call stack. A stmt-list prints as its statements, one per line
+    // at the list's own level.
+    std::vector<std::pair<ASTNode*, int>> pending;
+    if (node) pending.push_back({node, indentLevel});
+
+    while (!pending.empty()) {
+        auto [current, level] = pending.back();
+        pending.pop_back();
+
+        bool sequence = current->type == "stmt-list";
+        if (!sequence) {
+            // Create indentation
+            QString indent;
+            for (int i = 0; i < level; ++i) indent += "  | ";
+
+            // Add current node details
+            output += indent + QString::fromUtf8(current->type.data(), current->type.size());
+            if (!current->value.empty()) {
+                output += " (" + QString::fromUtf8(current->value.data(), current->value.size()) + ")";
+            }
+            output += "\n";
+        }
+
+        // Children next, first child on top
+        int childLevel = sequence ? level : level + 1;
+        for (size_t i = current->children.size(); i-- > 0;) {
+            pending.push_back({current->children[i], childLevel});
+        }
     }
 }
 void MainWindow::on_frame3button_clicked() // Corresponds to "Parse the Code"
@@ -189,19 +268,29 @@ void MainWindow::on_frame3button_clicked() // Corresponds to "Parse the Code"
         return;
     }
 
-    std::string codeStr = sourceCode.toStdString();
+    // The tree is kept up to date as the text is edited
+    const std::string& codeStr = sourceText.text();
 
     try {
-        std::vector<Token> tokens = scan(codeStr);
+        SyntaxTree tree = toSyntaxTree(sourceText.parser().ast(), codeStr);
 
-        Parser parser(tokens);
-        ASTNode* root = parser.parse();
+        // Every error is reported; the statements they spoiled show up as
+        // error nodes in the tree
+        const std::vector<ParseDiagnostic>& diagnostics = sourceText.parser().diagnostics();
+        QString errorText = parserErrorText(diagnostics, codeStr);
 
-        QString resultText = "Parsing Successful!\n\nTextual Syntax Tree:\n---------------------\n";
-        printASTToText(root, resultText, 0);
+        QString resultText = errorText.isEmpty()
+            ? QString("Parsing Successful!\n\n")
+            : QString("Parser Errors (%1):\n").arg(diagnostics.size()) + errorText + "\n";
+        resultText += "Textual Syntax Tree:\n---------------------\n";
+        printASTToText(tree.root(), resultText, 0);
 
         ui->textEdit_2->setText(resultText);
 
+        if (!errorText.isEmpty()) {
+            QMessageBox::critical(this, "Parser Error", errorText.trimmed());
+        }
+
     } catch (const std::exception& e) {
         QString errorMsg = QString("Parser Error:\n%1").arg(e.what());
         ui->textEdit_2->setText(errorMsg);
@@ -209,107 +298,93 @@ void MainWindow::on_frame3button_clicked() // Corresponds to "Parse the Code"
     }
 }
 
-bool MainWindow::isStatement(const std::string& type) {
-    return (type == "if" || type == "repeat" || type == "assign" ||
-            type == "read" || type == "write");
+// One "Line L, column C: message" line per diagnostic
+QString MainWindow::parserErrorText(const std::vector<ParseDiagnostic>& diagnostics, std::string_view source) {
+    QString errorText;
+    if (diagnostics.empty())
+        return errorText;
+
+    LineIndex lines(source);
+    for (const auto& diagnostic : diagnostics) {
+        SourceLocation location = lines.locate(diagnostic.offset);
+        errorText += QString("Line %1, column %2: %3\n")
+            .arg(location.line)
+            .arg(location.column)
+            .arg(QString::fromStdString(diagnostic.message));
+    }
+    return errorText;
 }
 
-// Corrected helper to distinguish "Else" (Vertical) from "Next Statement" (Horizontal)
-void MainWindow::categorizeChildren(ASTNode* parent, std::vector<ASTNode*>& vertical, ASTNode*& horizontal) {
-    horizontal = nullptr;
-    vertical.clear();
-
-    if (!parent) return;
-
-    // 1. IF Statement: [Cond, Then, (Else), (Next)]
-    if (parent->type == "if") {
-        // Child 0: Condition (Vertical)
-        // Child 1: Then-Part (Vertical)
-        // Child 2: Else-Part (Vertical) <-- This is the specific fix
-        // Child 3: Next Statement (Horizontal)
-
-        for (size_t i = 0; i < parent->children.size(); ++i) {
-            ASTNode* child = parent->children[i];
-
-            // Only treat the child as "Horizontal" (Next Stmt) if it is the
-            // 4th child (index 3) or later.
-            // This ensures the 3rd child (Index 2, the ELSE part) remains Vertical.
-            if (i >= 3 &&  isStatement(child->type)) {
-                horizontal = child;
-            } else {
-                vertical.push_back(child);
-            }
-        }
-    }
-    // 2. REPEAT Statement: [Body, Cond, (Next)]
-    else if (parent->type == "repeat") {
-        if (parent->children.size() > 0) vertical.push_back(parent->children[0]); // Body
-        if (parent->children.size() > 1) vertical.push_back(parent->children[1]); // Cond (Until)
-        if (parent->children.size() > 2) horizontal = parent->children[2];         // Next Stmt
-    }
-    // 3. Simple Statements (Assign, Read, Write)
-    else if (isStatement(parent->type)) {
-        for (ASTNode* child : parent->children) {
-            if (isStatement(child->type)) {
-                horizontal = child; // The chained statement
-            } else {
-                vertical.push_back(child); // Expressions/IDs
-            }
-        }
-    }
-    // 4. Expressions / Ops (Everything vertical)
-    else {
-        vertical = parent->children;
-    }
+bool MainWindow::isStatement(std::string_view type) {
+    return (type == "if" || type == "repeat" || type == "assign" ||
+            type == "read" || type == "write" || type == "error");
 }
+
+// Width of the drawing of `node` and everything below it. A stmt-list is
+// drawn as a row of its statements; anything else sits above its children.
 int MainWindow::getSize(ASTNode* node) {
     if (!node) return 0;
 
-    std::vector<ASTNode*> vertical;
-    ASTNode* horizontal = nullptr;
-    categorizeChildren(node, vertical, horizontal);
-
-    // Calculate width of vertical children (the subtree below)
-    int verticalWidth = 0;
-    if (vertical.empty()) {
-        verticalWidth = 80; // Minimum width for a node
-    } else {
-        for (ASTNode* child : vertical) {
-            verticalWidth += getSize(child);
+    if (node->type == "stmt-list") {
+        int rowWidth = 0;
+        for (ASTNode* statement : node->children) {
+            if (rowWidth > 0) rowWidth += 50; // gap to the next statement
+            rowWidth += getSize(statement);
         }
+        return rowWidth;
     }
 
-    int horizontalWidth = 0;
-    if (horizontal) {
-        horizontalWidth = 50 + getSize(horizontal);
+    if (node->children.empty()) {
+        return 80; // Minimum width for a node
+    }
+    int childrenWidth = 0;
+    for (ASTNode* child : node->children) {
+        childrenWidth += getSize(child);
     }
+    return childrenWidth;
+}
 
-    return verticalWidth + horizontalWidth;
+// Centre of the box drawn for `node` when its drawing starts at `x`. A
+// stmt-list has no box of its own; its first statement stands for it.
+int MainWindow::centerX(ASTNode* node, int x) {
+    while (node->type == "stmt-list" && !node->children.empty())
+        node = node->children[0];
+    return x + getSize(node) / 2;
 }
 
 void MainWindow::drawTreeRecursive(QGraphicsScene* scene, ASTNode* node, int x, int y){
     if (!node) return;
 
-    std::vector<ASTNode*> verticalChildren;
-    ASTNode* horizontalChild = nullptr;
-    categorizeChildren(node, verticalChildren, horizontalChild);
-
-    // Draw Current Node
     int nodeW = 60;
     int nodeH = 40;
 
-    int verticalSubtreeWidth = 0;
-    if (verticalChildren.empty()) verticalSubtreeWidth = 80;
-    else {
-        for(auto* v : verticalChildren) verticalSubtreeWidth += getSize(v);
+    QPen linePen(Qt::white);
+    linePen.setWidth(2);
+
+    // A sequence: its statements left to right, each linked to the next.
+    // Walked in a loop, so only nesting deepens the recursion.
+    if (node->type == "stmt-list") {
+        int hGap = 50;
+        int previousRight = 0;
+        for (size_t i = 0; i < node->children.size(); ++i) {
+            ASTNode* statement = node->children[i];
+            int statementCenterX = centerX(statement, x);
+            if (i > 0) {
+                scene->addLine(previousRight, y + nodeH/2,
+                               statementCenterX - nodeW/2, y + nodeH/2, linePen);
+            }
+            drawTreeRecursive(scene, statement, x, y);
+
+            previousRight = statementCenterX + nodeW/2;
+            x += getSize(statement) + hGap;
+        }
+        return;
     }
 
-    int currentCenterX = x + (verticalSubtreeWidth / 2) - (nodeW / 2);
+    // Draw Current Node, centred over its children
+    int currentCenterX = centerX(node, x) - nodeW/2;
 
     // Draw ShapeQPen
-    QPen linePen(Qt::white);
-    linePen.setWidth(2);
-
     QPen shapePen(Qt::black);
     shapePen.setWidth(2);
 
@@ -324,55 +399,23 @@ void MainWindow::drawTreeRecursive(QGraphicsScene* scene, ASTNode* node, int x,
         scene->addEllipse(currentCenterX, y, nodeW, nodeH, shapePen, brush);
 
     // Draw Text
-    QString label = QString::fromStdString(node->type);
-    if (!node->value.empty()) label += "\n(" + QString::fromStdString(node->value) + ")";
+    QString label = QString::fromUtf8(node->type.data(), node->type.size());
+    if (!node->value.empty()) label += "\n(" + QString::fromUtf8(node->value.data(), node->value.size()) + ")";
     QGraphicsTextItem* text = scene->addText(label);
     text->setPos(currentCenterX + (nodeW - text->boundingRect().width())/2,
                  y + (nodeH - text->boundingRect().height())/2);
 
 
-    // Draw Vertical Children
+    // Draw Children (conditions, bodies, operands) below
     int startX = x;
     int childY = y + 100;
 
-
-    for (ASTNode* child : verticalChildren) {
-        int childTotalWidth = getSize(child);
-
-        int childVerticalWidth = 0;
-        std::vector<ASTNode*> v_dummy; ASTNode* h_dummy;
-        categorizeChildren(child, v_dummy, h_dummy);
-        if (v_dummy.empty()) childVerticalWidth = 80;
-        else for(auto* v : v_dummy) childVerticalWidth += getSize(v);
-
-        int childCenterX = startX + (childVerticalWidth / 2);
-
-        scene->addLine(currentCenterX + nodeW/2, y + nodeH, childCenterX, childY, linePen);
+    for (ASTNode* child : node->children) {
+        scene->addLine(currentCenterX + nodeW/2, y + nodeH, centerX(child, startX), childY, linePen);
 
         drawTreeRecursive(scene, child, startX, childY);
 
-        startX += childTotalWidth; // Move past the entire child structure
-    }
-
-
-    // Draw Horizontal Child
-    if (horizontalChild) {
-        int hGap = 50;
-
-        int nextNodeX = (verticalChildren.empty()) ? (x + nodeW + hGap) : (startX + hGap);
-
-        int nextVerticalWidth = 0;
-        std::vector<ASTNode*> v_next; ASTNode* h_next;
-        categorizeChildren(horizontalChild, v_next, h_next);
-        if (v_next.empty()) nextVerticalWidth = 80;
-        else for(auto* v : v_next) nextVerticalWidth += getSize(v);
-
-        int nextNodeCenterX = nextNodeX + (nextVerticalWidth / 2);
-
-        scene->addLine(currentCenterX + nodeW, y + nodeH/2,
-                       nextNodeCenterX - 30, y + nodeH/2, linePen);
-
-        drawTreeRecursive(scene, horizontalChild, nextNodeX, y);
+        startX += getSize(child); // Move past the entire child structure
     }
 }
 void MainWindow::on_treebutton_clicked()
@@ -384,13 +427,18 @@ void MainWindow::on_treebutton_clicked()
     }
 
     try {
-        std::string codeStr = sourceCode.toStdString();
-        std::vector<Token> tokens = scan(codeStr);
-        Parser parser(tokens);
-        ASTNode* root = parser.parse();
+        const std::string& codeStr = sourceText.text();
+        SyntaxTree tree = toSyntaxTree(sourceText.parser().ast(), codeStr);
+        ASTNode* root = tree.root();
 
         if (!root) return;
 
+        // Draw the tree anyway, with error nodes where statements failed
+        QString errorText = parserErrorText(sourceText.parser().diagnostics(), codeStr);
+        if (!errorText.isEmpty()) {
+            QMessageBox::critical(this, "Parser Error", errorText.trimmed());
+        }
+
         QDialog* graphWindow = new QDialog(this);
         graphWindow->setWindowTitle("Syntax Tree Visualization");
         graphWindow->resize(1200, 600);
@@ -15,6 +15,7 @@
 #include <QString>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <QDialog>
 #include <QVBoxLayout>
 #include <QGraphicsView>
@@ -26,6 +27,7 @@
 #include "Scanner.h"
 #include "ASTNode.h"
 #include "parser.h"
+#include "EditorText.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -41,9 +43,10 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
     void printASTToText(ASTNode*, QString&, int);
-    bool isStatement(const std::string&);
-    void categorizeChildren(ASTNode*, std::vector<ASTNode*>&, ASTNode*&);
+    bool isStatement(std::string_view);
+    QString parserErrorText(const std::vector<ParseDiagnostic>&, std::string_view);
     int getSize(ASTNode* node);
+    int centerX(ASTNode* node, int x);
     void drawTreeRecursive(QGraphicsScene*, ASTNode*, int, int);
 
 private slots:
@@ -55,7 +58,14 @@ private slots:
 
     void on_treebutton_clicked();
 
+    void sourceContentsChanged(int position, int charsRemoved, int charsAdded);
+
 private:
     Ui::MainWindow *ui;
+
+    // Tokens and syntax tree of textEdit, kept current on every edit
+    EditorText sourceText;
+
+    int documentPosition(uint32_t offset) const;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,102 @@
+// Checks EditorText against the document it follows: random UTF-16
+// documents with line separators (which end a line but not a block),
+// no-break spaces and surrogate pairs get random edits, and after each one
+// text() must be the document's plain text in UTF-8, and every position
+// must map to a byte offset and back.
+
+#include "EditorText.h"
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr int Documents = 2000;
+constexpr int EditsPerDocument = 10;
+
+const char16_t* const Pieces[] = {
+    u"x := 1;", u"write x + 2", u"{ note }", u" ", u"\n",
+    u"\u2028",              // line separator (Shift+Enter)
+    u"\u2029",              // paragraph separator
+    u"\u00A0",              // no-break space
+    u"\u00E9", u"\u20AC",   // 2 and 3 bytes in UTF-8
+    u"\U0001F600",          // a surrogate pair
+};
+
+std::u16string randomPieces(std::mt19937& random, int count) {
+    std::u16string text;
+    for (int k = 0; k < count; k++)
+        text += Pieces[random() % std::size(Pieces)];
+    return text;
+}
+
+// Qt never puts a position between the halves of a surrogate pair
+bool splitsPair(const std::u16string& document, size_t position) {
+    return position > 0 && position < document.size() && document[position] >= 0xDC00 && document[position] < 0xE000;
+}
+
+// What is wrong with `editor` as a copy of `document`, or ""
+std::string check(const EditorText& editor, const std::u16string& document) {
+    if (editor.length() != document.size())
+        return "length " + std::to_string(editor.length()) + ", expected " + std::to_string(document.size());
+    if (editor.text() != EditorText::plainUtf8(document))
+        return "text \"" + editor.text() + "\", expected \"" + EditorText::plainUtf8(document) + "\"";
+    for (size_t position = 0; position <= document.size(); position++) {
+        if (splitsPair(document, position))
+            continue;
+        uint32_t offset = editor.offsetOf(position);
+        if (editor.positionOf(offset) != position)
+            return "position " + std::to_string(position) + " maps to byte " + std::to_string(offset) +
+                   ", which maps back to " + std::to_string(editor.positionOf(offset));
+    }
+    return "";
+}
+
+} // namespace
+
+int main() {
+    int failures = 0;
+    long edits = 0;
+
+    // Shift+Enter, then typing on the line it started
+    EditorText editor;
+    std::u16string document = u"x := 1;\u2028y := 2";
+    editor.setText(document);
+    editor.edit(document.size() - 1, 1, u"3");
+    document.replace(document.size() - 1, 1, u"3");
+    if (editor.text() != "x := 1;\ny := 3" || editor.parser().diagnostics().size() != 0) {
+        std::fprintf(stderr, "FAIL: an edit after a line separator gave \"%s\"\n", editor.text().c_str());
+        failures++;
+    }
+
+    for (int seed = 1; seed <= Documents && failures < 5; seed++) {
+        std::mt19937 random(seed);
+        document = randomPieces(random, random() % 12);
+        editor.setText(document);
+
+        for (int e = 0; e < EditsPerDocument; e++) {
+            size_t position = random() % (document.size() + 1);
+            size_t removed = random() % 3 == 0 ? random() % (document.size() - position + 1) : 0;
+            if (splitsPair(document, position))
+                position--;
+            if (splitsPair(document, position + removed))
+                removed++;
+            std::u16string inserted = randomPieces(random, random() % 3);
+            editor.edit(position, removed, inserted);
+            document.replace(position, removed, inserted);
+            edits++;
+
+            std::string problem = check(editor, document);
+            if (!problem.empty()) {
+                std::fprintf(stderr, "FAIL: document %d, edit %d (%zu units at %zu): %s\n", seed, e, removed, position,
+                             problem.c_str());
+                failures++;
+                break;
+            }
+        }
+    }
+
+    if (failures == 0)
+        std::printf("%ld edits kept the text in step with the document\n", edits);
+    return failures == 0 ? 0 : 1;
+}
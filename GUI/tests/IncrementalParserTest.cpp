@@ -0,0 +1,152 @@
+// Checks IncrementalParser against parsing from scratch: random programs
+// get random edits, and after most of them ast() and diagnostics() must
+// match Parser(scan(text)).parse(), and the tree must round-trip through an
+// AST file. The unchecked edits leave the spans' moves pending for the next.
+// Then a long program gets statements inserted between its own, and each
+// must be reparsed from nearby, not from the top.
+
+#include "AstFile.h"
+#include "IncrementalParser.h"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int Programs = 3000;
+constexpr int EditsPerProgram = 8;
+constexpr int LongProgram = 5000;       // statements
+constexpr int LocalEdits = 500;
+constexpr size_t LocalTokens = 64;      // at most, for a reparse around one statement
+
+const char* const Statements[] = {
+    "x := 1",
+    "read y",
+    "write x + 2 * (y - 3)",
+    "if x < 1 then y := 2 end",
+    "if a = b then c := 1 else d := 2; e := 3 end",
+    "repeat n := n - 1; write n until n = 0",
+    "if (a) then repeat b := (c) until (d) end",
+};
+
+// Keywords, separators and broken tokens, so edits also open, close and
+// break blocks
+const char* const Insertions[] = {
+    ";", " ", "end", "else", "until", "if", "then", "repeat", "x", "7", ":=",
+    "+", "(", ")", "{", "}", "@", "\n", "if q then", "z := 9;",
+};
+
+// The tree from the root down, one node a line, with names spelled out
+// (the incremental tree numbers them by the lexer's table), then the errors
+std::string dump(const FlatAst& ast, const std::vector<ParseDiagnostic>& diagnostics) {
+    std::string out;
+    std::vector<std::pair<NodeId, int>> pending;
+    if (ast.root() != NoNode)
+        pending.push_back({ast.root(), 0});
+    while (!pending.empty()) {
+        auto [id, depth] = pending.back();
+        pending.pop_back();
+        const FlatNode& node = ast[id];
+        out += std::string(depth, ' ') + std::string(nodeKindName(node.kind)) + std::string(opKindSymbol(node.op));
+        if (node.kind == NodeKind::Assign || node.kind == NodeKind::Read || node.kind == NodeKind::Id)
+            out += " " + std::string(ast.name(id));
+        if (node.kind == NodeKind::Const)
+            out += " " + std::to_string(ast.literal(id));
+        out += " " + std::to_string(node.span.begin) + "-" + std::to_string(node.span.end) + "\n";
+
+        std::vector<NodeId> children;
+        for (NodeId child = node.firstChild; child != NoNode; child = ast[child].nextSibling)
+            children.push_back(child);
+        for (auto child = children.rbegin(); child != children.rend(); ++child)
+            pending.push_back({*child, depth + 1});
+    }
+    for (const ParseDiagnostic& diagnostic : diagnostics)
+        out += "error at " + std::to_string(diagnostic.offset) + ": " + diagnostic.message + "\n";
+    return out;
+}
+
+std::string parsedAfresh(const std::string& text) {
+    ScanResult scanned = scan(text);
+    Parser parser(scanned);
+    FlatAst ast = parser.parse();
+    return dump(ast, parser.diagnostics());
+}
+
+} // namespace
+
+int main() {
+    const std::string astFile = "IncrementalParserTest.ast";
+    int failures = 0;
+    long edits = 0;
+
+    for (int seed = 1; seed <= Programs && failures < 5; seed++) {
+        std::mt19937 random(seed);
+        std::string text;
+        for (int k = 0, count = 3 + random() % 30; k < count; k++)
+            text += (k > 0 ? ";\n" : "") + std::string(Statements[random() % std::size(Statements)]);
+
+        IncrementalParser incremental(text);
+        for (int e = 0; e < EditsPerProgram; e++) {
+            size_t length = incremental.text().size();
+            size_t offset = random() % (length + 1);
+            size_t removed = random() % 3 == 0 ? random() % std::min<size_t>(8, length - offset + 1) : 0;
+            std::string inserted = random() % 4 == 0 ? "" : Insertions[random() % std::size(Insertions)];
+            if (inserted.empty() && removed == 0)
+                removed = std::min<size_t>(1, length - offset);
+            incremental.edit(offset, removed, inserted);
+            edits++;
+            if (e + 1 < EditsPerProgram && random() % 3 == 0)
+                continue;
+
+            std::string got = dump(incremental.ast(), incremental.diagnostics());
+            if (got != parsedAfresh(incremental.text())) {
+                std::fprintf(stderr, "FAIL: program %d, edit %d (%zu bytes at %zu for \"%s\") differs from a fresh parse of:\n%s\n",
+                             seed, e, removed, offset, inserted.c_str(), incremental.text().c_str());
+                failures++;
+                break;
+            }
+
+            // Every node in the array, not only those under the root, must
+            // make a valid tree
+            try {
+                writeAstFile(astFile, incremental.ast(), incremental.diagnostics(), incremental.text());
+                AstFile loaded(astFile);
+                if (dump(loaded.ast(), loaded.diagnostics()) != got)
+                    throw std::runtime_error("the tree read back differs");
+            } catch (const std::exception& error) {
+                std::fprintf(stderr, "FAIL: program %d, edit %d: %s\n", seed, e, error.what());
+                failures++;
+                break;
+            }
+        }
+    }
+    std::remove(astFile.c_str());
+
+    std::mt19937 random(0);
+    std::string text;
+    for (int k = 0; k < LongProgram; k++)
+        text += (k > 0 ? ";\n" : "") + std::string(Statements[k % std::size(Statements)]);
+    IncrementalParser incremental(text);
+    const size_t tokenCount = incremental.lexer().tokens().size();
+    size_t mostParsed = 0;
+    for (int e = 0; e < LocalEdits; e++) {
+        size_t offset = incremental.text().find(";\n", random() % incremental.text().size());
+        if (offset == std::string::npos)
+            continue;
+        incremental.edit(offset + 2, 0, "z := 9;\n");
+        mostParsed = std::max(mostParsed, incremental.lastParsedTokens());
+    }
+    if (mostParsed > LocalTokens) {
+        std::fprintf(stderr, "FAIL: an edit between two statements of %zu tokens parsed %zu of them\n", tokenCount,
+                     mostParsed);
+        failures++;
+    } else if (dump(incremental.ast(), incremental.diagnostics()) != parsedAfresh(incremental.text())) {
+        std::fprintf(stderr, "FAIL: the long program differs from a fresh parse after %d edits\n", LocalEdits);
+        failures++;
+    }
+
+    if (failures == 0)
+        std::printf("%ld edits matched a fresh parse; local edits parsed at most %zu tokens\n", edits, mostParsed);
+    return failures == 0 ? 0 : 1;
+}
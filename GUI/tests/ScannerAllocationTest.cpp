@@ -0,0 +1,108 @@
+// Checks that a warmed-up Scanner rescans without allocating: every
+// operator new in the process is counted around reset() and scan().
+
+#include "Scanner.h"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+size_t allocations = 0;
+
+// A program of `statements` assignments over the names prefix0..prefix999
+string program(const string &prefix, size_t statements)
+{
+    string text;
+    for (size_t k = 0; k < statements; k++)
+    {
+        size_t name = k * 7919 % 1000;
+        text += prefix + to_string(name) + " := " + prefix + to_string((name + 1) % 1000) + " + " +
+                to_string(k) + ";";
+        text += k % 10 == 0 ? " { every tenth line }\n" : "\n";
+    }
+    text += "write " + prefix + "0";
+    return text;
+}
+
+bool sameAsScan(const ScanResult &result, const string &text)
+{
+    ScanResult expected = scan(text);
+    if (result.tokens.size() != expected.tokens.size() || result.symbols->size() != expected.symbols->size() ||
+        result.lines.lineCount() != expected.lines.lineCount())
+        return false;
+    for (size_t k = 0; k < result.tokens.size(); k++)
+    {
+        const Token &got = result.tokens[k];
+        const Token &want = expected.tokens[k];
+        if (got.type != want.type || got.offset != want.offset || got.lexeme != want.lexeme ||
+            (got.type == TokenType::ID && got.symbol != want.symbol) ||
+            (got.type == TokenType::NUMBER && got.value != want.value))
+            return false;
+    }
+    return true;
+}
+
+// Allocations made by reset(text) and scan()
+size_t rescan(Scanner &scanner, const string &text)
+{
+    size_t before = allocations;
+    scanner.reset(text);
+    scanner.scan();
+    return allocations - before;
+}
+} // namespace
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *memory = malloc(size ? size : 1))
+        return memory;
+    throw bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+int main()
+{
+    const string first = program("x", 40000);
+    const string same = first;                    // another buffer, same text
+    const string shorter = program("x", 30000);   // same names, fewer tokens
+    const string renamed = program("y", 40000);   // other names of the same lengths
+
+    Scanner scanner;
+    rescan(scanner, first);
+
+    int failures = 0;
+    const pair<const char *, const string *> runs[] = {
+        {"same text", &same}, {"fewer tokens", &shorter}, {"other names", &renamed}, {"first text again", &first}};
+    for (const auto &[what, text] : runs)
+    {
+        size_t count = rescan(scanner, *text);
+        if (count != 0)
+        {
+            fprintf(stderr, "FAIL: rescanning (%s) made %zu allocations\n", what, count);
+            failures++;
+        }
+        if (!sameAsScan(scanner.result(), *text))
+        {
+            fprintf(stderr, "FAIL: rescanning (%s) differs from scan()\n", what);
+            failures++;
+        }
+    }
+
+    if (failures == 0)
+        printf("Scanner rescans made no allocations\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// Checks that a token file survives the round trip, and that one whose
+// diagnostic points past the source it would quote is rejected rather
+// than read out of bounds.
+
+#include "TokenFile.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+const string Filename = "TokenFileTest.tok";
+
+// Whether loading the file throws std::runtime_error
+bool rejected()
+{
+    try
+    {
+        TokenFile loaded(Filename);
+        return false;
+    }
+    catch (const runtime_error &)
+    {
+        return true;
+    }
+}
+
+// Overwrites the offset of the last diagnostic, which ends the file
+// (kind, offset, line, column, as uint32_t each)
+void setLastDiagnosticOffset(uint32_t offset)
+{
+    fstream file(Filename, ios::in | ios::out | ios::binary);
+    file.seekp(-12, ios::end);
+    file.write(reinterpret_cast<const char *>(&offset), sizeof(offset));
+}
+} // namespace
+
+int main()
+{
+    int failures = 0;
+
+    // Each source ends with the character its only diagnostic quotes
+    for (const string source : {"x := @", "x :"})
+    {
+        Interner symbols;
+        TokenBuffer tokens = scanToBuffer(source, symbols);
+        writeTokenFile(Filename, tokens, symbols);
+        try
+        {
+            TokenFile loaded(Filename);
+            if (loaded.source() != source || loaded.tokens().size() != tokens.size() ||
+                loaded.tokens().diagnostics().size() != 1 ||
+                loaded.tokens().diagnostics()[0].message != tokens.diagnostics()[0].message)
+            {
+                fprintf(stderr, "FAIL: \"%s\" reads back differently\n", source.c_str());
+                failures++;
+            }
+        }
+        catch (const exception &error)
+        {
+            fprintf(stderr, "FAIL: \"%s\": %s\n", source.c_str(), error.what());
+            failures++;
+        }
+
+        setLastDiagnosticOffset(static_cast<uint32_t>(source.length()));
+        if (!rejected())
+        {
+            fprintf(stderr, "FAIL: \"%s\" loads with a diagnostic at the end of the source\n", source.c_str());
+            failures++;
+        }
+    }
+    remove(Filename.c_str());
+
+    if (failures == 0)
+        printf("token files round-trip, and a diagnostic past the source is rejected\n");
+    return failures == 0 ? 0 : 1;
+}